@@ -1,44 +1,158 @@
 #pragma once
+#include <algorithm>
+#include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+#include "Stream/CompressedStream.h"
 
 const std::string MEALY_TO_MOORE = "mealy-to-moore";
 const std::string MOORE_TO_MEALY = "moore-to-mealy";
+const std::string PRUNE = "prune";
+const std::string REACHABLE_OPTION = "--reachable";
+const std::string INCREMENTAL_OPTION = "--incremental";
+const std::string COMPRESSION_LEVEL_OPTION = "--compression-level";
+constexpr char OPERATION_SEPARATOR = ',';
 
 enum class Operation
 {
     MealyToMoore,
-    MooreToMealy
+    MooreToMealy,
+    Prune
+};
+
+enum class AutomataType
+{
+    Mealy,
+    Moore
 };
 
 struct Args
 {
-    Operation operation;
+    // Операции выполняются по порядку, автомат передаётся между ними в памяти
+    std::vector<Operation> operations;
+    AutomataType inputType;
     std::string inputFilename;
     std::string outputFilename;
+    bool reachableOnly = false;
+    // Повторный перевод по индексу предыдущего запуска, только для одиночного mealy-to-moore
+    bool incremental = false;
+    std::optional<int> compressionLevel = std::nullopt;
 };
 
+inline Operation ParseOperation(const std::string& name)
+{
+    if (name == MEALY_TO_MOORE)
+    {
+        return Operation::MealyToMoore;
+    }
+    if (name == MOORE_TO_MEALY)
+    {
+        return Operation::MooreToMealy;
+    }
+    if (name == PRUNE)
+    {
+        return Operation::Prune;
+    }
+
+    throw std::invalid_argument("Invalid operation \"" + name + "\"");
+}
+
+// Тип входного автомата определяется первой операцией перевода; далее проверяется,
+// что каждая операция перевода получает автомат нужного типа
+inline AutomataType GetInputType(const std::vector<Operation>& operations)
+{
+    const auto firstConversion = std::find_if(operations.begin(), operations.end(), [](const Operation operation) {
+        return operation != Operation::Prune;
+    });
+    if (firstConversion == operations.end())
+    {
+        throw std::invalid_argument("Operation chain must contain " + MEALY_TO_MOORE + " or " + MOORE_TO_MEALY);
+    }
+
+    const AutomataType inputType = *firstConversion == Operation::MealyToMoore ? AutomataType::Mealy : AutomataType::Moore;
+
+    AutomataType type = inputType;
+    for (const auto operation: operations)
+    {
+        if (operation == Operation::MealyToMoore)
+        {
+            if (type != AutomataType::Mealy)
+            {
+                throw std::invalid_argument(MEALY_TO_MOORE + " must follow an operation producing Mealy automata");
+            }
+            type = AutomataType::Moore;
+        }
+        else if (operation == Operation::MooreToMealy)
+        {
+            if (type != AutomataType::Moore)
+            {
+                throw std::invalid_argument(MOORE_TO_MEALY + " must follow an operation producing Moore automata");
+            }
+            type = AutomataType::Mealy;
+        }
+    }
+
+    return inputType;
+}
+
 inline Args ParseArgs(const int argc, char** argv)
 {
-    if (argc != 4)
+    if (argc < 4)
     {
-        throw std::invalid_argument("Invalid number of arguments. Must be: <operation> <inputFilename> <outputFilename>");
+        throw std::invalid_argument("Invalid number of arguments. Must be: <operation>[,<operation>...] <inputFilename> <outputFilename> [options]");
     }
 
-    Operation operation;
+    std::vector<Operation> operations;
+    std::stringstream ss(argv[1]);
+    std::string operationName;
+    while (std::getline(ss, operationName, OPERATION_SEPARATOR))
+    {
+        operations.push_back(ParseOperation(operationName));
+    }
 
-    if (argv[1] == MEALY_TO_MOORE)
+    Args args { operations, GetInputType(operations), argv[2], argv[3] };
+    const bool hasMealyToMoore = std::find(operations.begin(), operations.end(), Operation::MealyToMoore) != operations.end();
+
+    for (int index = 4; index < argc; ++index)
     {
-        operation = Operation::MealyToMoore;
+        if (argv[index] == REACHABLE_OPTION && hasMealyToMoore)
+        {
+            args.reachableOnly = true;
+        }
+        else if (argv[index] == INCREMENTAL_OPTION && operations == std::vector { Operation::MealyToMoore })
+        {
+            args.incremental = true;
+        }
+        else if (argv[index] == COMPRESSION_LEVEL_OPTION && index + 1 < argc)
+        {
+            try
+            {
+                args.compressionLevel = std::stoi(argv[++index]);
+            }
+            catch (const std::exception&)
+            {
+                throw std::invalid_argument("Invalid compression level \"" + std::string(argv[index]) + "\"");
+            }
+        }
+        else
+        {
+            throw std::invalid_argument("Invalid option \"" + std::string(argv[index]) + "\"");
+        }
     }
-    else if (argv[1] == MOORE_TO_MEALY)
+
+    if (args.incremental && args.reachableOnly)
     {
-        operation = Operation::MooreToMealy;
+        throw std::invalid_argument(INCREMENTAL_OPTION + " cannot be combined with " + REACHABLE_OPTION);
     }
-    else
+
+    if (args.compressionLevel.has_value()
+        && CompressedStream::GetFormatFromExtension(args.outputFilename) == CompressionFormat::None)
     {
-        throw std::invalid_argument("Invalid operation");
+        throw std::invalid_argument(COMPRESSION_LEVEL_OPTION + " requires .gz or .zst output file");
     }
 
-    return { operation, argv[2], argv[3] };
+    return args;
 }
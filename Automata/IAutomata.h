@@ -2,8 +2,12 @@
 #include <memory>
 #include <string>
 
+#include "../Stream/CompressedStream.h"
+
 struct Transition
 {
+    Transition() = default;
+
     Transition(const std::string& nextState, const std::string& outputSymbol)
         : nextState(nextState),
         outputSymbol(outputSymbol)
@@ -20,12 +24,14 @@ struct Transition
         }
         return outputSymbol < other.outputSymbol;
     }
+
+    bool operator==(const Transition& other) const = default;
 };
 
 class IAutomata
 {
 public:
-    virtual void ExportToCsv(const std::string& filename) const = 0;
+    virtual void ExportToCsv(const std::string& filename, const OutputCompression& compression = {}) const = 0;
 
     virtual ~IAutomata() = default;
 };
@@ -0,0 +1,770 @@
+#pragma once
+
+#ifndef INDEXED_AUTOMATA_H
+#define INDEXED_AUTOMATA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "IAutomata.h"
+#include "SparseTransitionTable.h"
+
+enum class IndexWidth
+{
+    UInt8,
+    UInt16,
+    UInt32
+};
+
+// Выбирает самый узкий тип индекса, в который помещаются значения [0, count)
+inline IndexWidth SelectIndexWidth(const size_t count)
+{
+    if (count <= size_t(std::numeric_limits<uint8_t>::max()) + 1)
+    {
+        return IndexWidth::UInt8;
+    }
+    if (count <= size_t(std::numeric_limits<uint16_t>::max()) + 1)
+    {
+        return IndexWidth::UInt16;
+    }
+    if (count <= size_t(std::numeric_limits<uint32_t>::max()) + 1)
+    {
+        return IndexWidth::UInt32;
+    }
+
+    throw std::length_error("Automata is too large: " + std::to_string(count) + " identifiers");
+}
+
+// Вызывает function(std::type_identity<Index>{}) с типом индекса, соответствующим width
+template <typename Function>
+decltype(auto) DispatchIndexWidth(const IndexWidth width, Function&& function)
+{
+    switch (width)
+    {
+        case IndexWidth::UInt8:
+            return function(std::type_identity<uint8_t>{});
+        case IndexWidth::UInt16:
+            return function(std::type_identity<uint16_t>{});
+        default:
+            return function(std::type_identity<uint32_t>{});
+    }
+}
+
+class SymbolTable
+{
+public:
+    uint32_t Intern(const std::string& name)
+    {
+        auto [it, inserted] = m_ids.try_emplace(name, static_cast<uint32_t>(m_names.size()));
+        if (inserted)
+        {
+            m_names.push_back(name);
+        }
+
+        return it->second;
+    }
+
+    [[nodiscard]] std::optional<uint32_t> Find(const std::string& name) const
+    {
+        const auto it = m_ids.find(name);
+        if (it == m_ids.end())
+        {
+            return std::nullopt;
+        }
+
+        return it->second;
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetNames() const
+    {
+        return m_names;
+    }
+
+    std::vector<std::string> ReleaseNames()
+    {
+        m_ids.clear();
+        return std::move(m_names);
+    }
+
+private:
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, uint32_t> m_ids;
+};
+
+template <typename ToIndex, typename FromIndex>
+std::vector<ToIndex> NarrowIndexes(std::vector<FromIndex>&& indexes)
+{
+    if constexpr (std::is_same_v<ToIndex, FromIndex>)
+    {
+        return std::move(indexes);
+    }
+    else
+    {
+        std::vector<ToIndex> narrowed;
+        narrowed.reserve(indexes.size());
+        for (const auto index: indexes)
+        {
+            if (index > std::numeric_limits<ToIndex>::max())
+            {
+                throw std::out_of_range("Index does not fit the selected width");
+            }
+            narrowed.push_back(static_cast<ToIndex>(index));
+        }
+        indexes = {};
+
+        return narrowed;
+    }
+}
+
+constexpr uint32_t REMOVED_STATE = std::numeric_limits<uint32_t>::max();
+
+// Новые номера выбранных состояний; остальным состояниям соответствует REMOVED_STATE
+inline std::vector<uint32_t> GetNewStateIndexes(const size_t stateCount, const std::vector<unsigned>& states)
+{
+    std::vector<uint32_t> newIndexes(stateCount, REMOVED_STATE);
+    for (uint32_t index = 0; index < states.size(); ++index)
+    {
+        newIndexes.at(states[index]) = index;
+    }
+
+    return newIndexes;
+}
+
+inline uint32_t GetNewStateIndex(const std::vector<uint32_t>& newIndexes, const size_t state)
+{
+    if (newIndexes[state] == REMOVED_STATE)
+    {
+        throw std::invalid_argument("Transition leads to a removed state");
+    }
+
+    return newIndexes[state];
+}
+
+// Автомат Мили, в котором состояния и выходные символы заменены индексами типа Index.
+// Таблица хранится по столбцам: переходы состояния s занимают
+// [s * inputCount, (s + 1) * inputCount).
+template <typename Index>
+class IndexedMealyAutomata
+{
+public:
+    IndexedMealyAutomata(
+        std::vector<std::string>&& states,
+        std::vector<std::string>&& inputSymbols,
+        std::vector<std::string>&& outputSymbols,
+        std::vector<Index>&& nextStates,
+        std::vector<Index>&& outputs
+    )
+        : m_states(std::move(states)),
+        m_inputSymbols(std::move(inputSymbols)),
+        m_outputSymbols(std::move(outputSymbols)),
+        m_nextStates(std::move(nextStates)),
+        m_outputs(std::move(outputs))
+    {
+        if (m_nextStates.size() != m_states.size() * m_inputSymbols.size() || m_outputs.size() != m_nextStates.size())
+        {
+            throw std::invalid_argument("Inconsistent indexed Mealy transition table");
+        }
+    }
+
+    template <typename OtherIndex>
+    explicit IndexedMealyAutomata(IndexedMealyAutomata<OtherIndex>&& other)
+        : IndexedMealyAutomata(
+            std::move(other.m_states),
+            std::move(other.m_inputSymbols),
+            std::move(other.m_outputSymbols),
+            NarrowIndexes<Index>(std::move(other.m_nextStates)),
+            NarrowIndexes<Index>(std::move(other.m_outputs)))
+    {}
+
+    [[nodiscard]] size_t GetStateCount() const
+    {
+        return m_states.size();
+    }
+
+    [[nodiscard]] size_t GetInputCount() const
+    {
+        return m_inputSymbols.size();
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetStates() const
+    {
+        return m_states;
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetInputSymbols() const
+    {
+        return m_inputSymbols;
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetOutputSymbols() const
+    {
+        return m_outputSymbols;
+    }
+
+    [[nodiscard]] std::span<const Index> GetNextStates(const size_t state) const
+    {
+        return { m_nextStates.data() + state * m_inputSymbols.size(), m_inputSymbols.size() };
+    }
+
+    [[nodiscard]] std::span<const Index> GetOutputs(const size_t state) const
+    {
+        return { m_outputs.data() + state * m_inputSymbols.size(), m_inputSymbols.size() };
+    }
+
+    // Возвращает автомат только с указанными состояниями в заданном порядке;
+    // переходы из них должны вести в указанные состояния
+    [[nodiscard]] IndexedMealyAutomata SelectStates(const std::vector<unsigned>& states) const
+    {
+        const auto newIndexes = GetNewStateIndexes(m_states.size(), states);
+
+        std::vector<std::string> selectedStates;
+        std::vector<Index> nextStates;
+        std::vector<Index> outputs;
+        selectedStates.reserve(states.size());
+        nextStates.reserve(states.size() * m_inputSymbols.size());
+        outputs.reserve(states.size() * m_inputSymbols.size());
+        for (const auto state: states)
+        {
+            selectedStates.push_back(m_states.at(state));
+            for (const auto nextState: GetNextStates(state))
+            {
+                nextStates.push_back(static_cast<Index>(GetNewStateIndex(newIndexes, nextState)));
+            }
+            const auto stateOutputs = GetOutputs(state);
+            outputs.insert(outputs.end(), stateOutputs.begin(), stateOutputs.end());
+        }
+
+        auto inputSymbols = m_inputSymbols;
+        auto outputSymbols = m_outputSymbols;
+        return {
+            std::move(selectedStates),
+            std::move(inputSymbols),
+            std::move(outputSymbols),
+            std::move(nextStates),
+            std::move(outputs)
+        };
+    }
+
+private:
+    template <typename> friend class IndexedMealyAutomata;
+
+    std::vector<std::string> m_states;
+    std::vector<std::string> m_inputSymbols;
+    std::vector<std::string> m_outputSymbols;
+    std::vector<Index> m_nextStates;
+    std::vector<Index> m_outputs;
+};
+
+// Автомат Мура с индексами типа Index; таблица переходов хранится по столбцам
+template <typename Index>
+class IndexedMooreAutomata
+{
+public:
+    IndexedMooreAutomata(
+        std::vector<std::string>&& states,
+        std::vector<std::string>&& inputSymbols,
+        std::vector<std::string>&& outputSymbols,
+        std::vector<Index>&& stateOutputs,
+        std::vector<Index>&& nextStates
+    )
+        : m_states(std::move(states)),
+        m_inputSymbols(std::move(inputSymbols)),
+        m_outputSymbols(std::move(outputSymbols)),
+        m_stateOutputs(std::move(stateOutputs)),
+        m_nextStates(std::move(nextStates))
+    {
+        if (m_stateOutputs.size() != m_states.size() || m_nextStates.size() != m_states.size() * m_inputSymbols.size())
+        {
+            throw std::invalid_argument("Inconsistent indexed Moore transition table");
+        }
+    }
+
+    template <typename OtherIndex>
+    explicit IndexedMooreAutomata(IndexedMooreAutomata<OtherIndex>&& other)
+        : IndexedMooreAutomata(
+            std::move(other.m_states),
+            std::move(other.m_inputSymbols),
+            std::move(other.m_outputSymbols),
+            NarrowIndexes<Index>(std::move(other.m_stateOutputs)),
+            NarrowIndexes<Index>(std::move(other.m_nextStates)))
+    {}
+
+    [[nodiscard]] size_t GetStateCount() const
+    {
+        return m_states.size();
+    }
+
+    [[nodiscard]] size_t GetInputCount() const
+    {
+        return m_inputSymbols.size();
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetStates() const
+    {
+        return m_states;
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetInputSymbols() const
+    {
+        return m_inputSymbols;
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetOutputSymbols() const
+    {
+        return m_outputSymbols;
+    }
+
+    [[nodiscard]] const std::vector<Index>& GetStateOutputs() const
+    {
+        return m_stateOutputs;
+    }
+
+    [[nodiscard]] const std::vector<Index>& GetNextStates() const
+    {
+        return m_nextStates;
+    }
+
+    [[nodiscard]] std::span<const Index> GetNextStates(const size_t state) const
+    {
+        return { m_nextStates.data() + state * m_inputSymbols.size(), m_inputSymbols.size() };
+    }
+
+    // Возвращает автомат только с указанными состояниями в заданном порядке;
+    // переходы из них должны вести в указанные состояния
+    [[nodiscard]] IndexedMooreAutomata SelectStates(const std::vector<unsigned>& states) const
+    {
+        const auto newIndexes = GetNewStateIndexes(m_states.size(), states);
+
+        std::vector<std::string> selectedStates;
+        std::vector<Index> stateOutputs;
+        std::vector<Index> nextStates;
+        selectedStates.reserve(states.size());
+        stateOutputs.reserve(states.size());
+        nextStates.reserve(states.size() * m_inputSymbols.size());
+        for (const auto state: states)
+        {
+            selectedStates.push_back(m_states.at(state));
+            stateOutputs.push_back(m_stateOutputs[state]);
+            for (const auto nextState: GetNextStates(state))
+            {
+                nextStates.push_back(static_cast<Index>(GetNewStateIndex(newIndexes, nextState)));
+            }
+        }
+
+        auto inputSymbols = m_inputSymbols;
+        auto outputSymbols = m_outputSymbols;
+        return {
+            std::move(selectedStates),
+            std::move(inputSymbols),
+            std::move(outputSymbols),
+            std::move(stateOutputs),
+            std::move(nextStates)
+        };
+    }
+
+private:
+    template <typename> friend class IndexedMooreAutomata;
+
+    std::vector<std::string> m_states;
+    std::vector<std::string> m_inputSymbols;
+    std::vector<std::string> m_outputSymbols;
+    std::vector<Index> m_stateOutputs;
+    std::vector<Index> m_nextStates;
+};
+
+template <template <typename> class Automata>
+using IndexWidthVariant = std::variant<Automata<uint8_t>, Automata<uint16_t>, Automata<uint32_t>>;
+
+using AnyIndexedMealyAutomata = IndexWidthVariant<IndexedMealyAutomata>;
+using AnyIndexedMooreAutomata = IndexWidthVariant<IndexedMooreAutomata>;
+
+// Переводит автомат в самый узкий тип индекса, вмещающий idCount идентификаторов
+template <template <typename> class Automata>
+IndexWidthVariant<Automata> NarrowToIndexWidth(Automata<uint32_t>&& automata, const size_t idCount)
+{
+    return DispatchIndexWidth(SelectIndexWidth(idCount), [&]<typename Index>(std::type_identity<Index>) {
+        return IndexWidthVariant<Automata>(std::in_place_type<Automata<Index>>, std::move(automata));
+    });
+}
+
+// Самое частое значение каждого столбца и число ячеек, которые от него отличаются
+struct ColumnDefaults
+{
+    // Вход, на котором в столбце встречается значение по умолчанию; пусто, если входов нет
+    std::vector<uint32_t> inputs;
+    size_t exceptionCount = 0;
+    size_t cellCount = 0;
+
+    // Разреженный вид хранит значения по умолчанию и исключения; таблица без ячеек
+    // в нём ничего не выигрывает
+    [[nodiscard]] bool IsSparseCheaper() const
+    {
+        return cellCount != 0 && (inputs.size() + exceptionCount) * SPARSE_CELL_COST <= cellCount;
+    }
+};
+
+namespace IndexedController
+{
+    inline uint32_t GetStateIndex(const SymbolTable& states, const std::string& state)
+    {
+        const auto index = states.Find(state);
+        if (!index)
+        {
+            throw std::invalid_argument("Unknown state \"" + state + "\" in transition table");
+        }
+
+        return *index;
+    }
+
+    inline void InternState(SymbolTable& states, const std::string& state)
+    {
+        const size_t expectedIndex = states.GetNames().size();
+        if (states.Intern(state) != expectedIndex)
+        {
+            throw std::invalid_argument("Duplicate state \"" + state + "\"");
+        }
+    }
+
+    // Переставляет таблицу, хранящуюся по строкам, в хранение по столбцам с индексами типа Index
+    template <typename Index>
+    std::vector<Index> TransposeRows(std::vector<uint32_t>&& rows, const size_t stateCount, const size_t inputCount)
+    {
+        std::vector<Index> columns(rows.size());
+        for (size_t input = 0; input < inputCount; ++input)
+        {
+            for (size_t state = 0; state < stateCount; ++state)
+            {
+                columns[state * inputCount + input] = static_cast<Index>(rows[input * stateCount + state]);
+            }
+        }
+        rows = {};
+
+        return columns;
+    }
+
+    // getKey(state, input) возвращает ключ ячейки: равные ячейки имеют равные ключи.
+    // Значение, занимающее больше половины столбца, находится голосованием Бойера-Мура
+    // за два прохода по строкам; остальные столбцы сортируются
+    template <typename GetKey>
+    ColumnDefaults FindColumnDefaults(const size_t stateCount, const size_t inputCount, GetKey&& getKey)
+    {
+        ColumnDefaults defaults;
+        defaults.cellCount = stateCount * inputCount;
+        if (inputCount == 0)
+        {
+            return defaults;
+        }
+
+        std::vector<uint64_t> candidates(stateCount);
+        std::vector<uint32_t> votes(stateCount, 0);
+        for (uint32_t input = 0; input < inputCount; ++input)
+        {
+            for (size_t state = 0; state < stateCount; ++state)
+            {
+                const uint64_t key = getKey(state, input);
+                if (votes[state] == 0)
+                {
+                    candidates[state] = key;
+                    votes[state] = 1;
+                }
+                else if (candidates[state] == key)
+                {
+                    ++votes[state];
+                }
+                else
+                {
+                    --votes[state];
+                }
+            }
+        }
+
+        std::vector<uint32_t> candidateCounts(stateCount, 0);
+        std::vector<uint32_t> candidateInputs(stateCount, 0);
+        for (uint32_t input = 0; input < inputCount; ++input)
+        {
+            for (size_t state = 0; state < stateCount; ++state)
+            {
+                if (getKey(state, input) == candidates[state] && candidateCounts[state]++ == 0)
+                {
+                    candidateInputs[state] = input;
+                }
+            }
+        }
+
+        defaults.inputs.reserve(stateCount);
+        std::vector<std::pair<uint64_t, uint32_t>> column;
+        for (size_t state = 0; state < stateCount; ++state)
+        {
+            if (candidateCounts[state] * 2 > inputCount)
+            {
+                defaults.inputs.push_back(candidateInputs[state]);
+                defaults.exceptionCount += inputCount - candidateCounts[state];
+                continue;
+            }
+
+            column.resize(inputCount);
+            for (uint32_t input = 0; input < inputCount; ++input)
+            {
+                column[input] = { getKey(state, input), input };
+            }
+            std::sort(column.begin(), column.end());
+
+            size_t mostFrequent = 0;
+            size_t mostFrequentCount = 0;
+            for (size_t first = 0; first < inputCount;)
+            {
+                size_t last = first + 1;
+                while (last < inputCount && column[last].first == column[first].first)
+                {
+                    ++last;
+                }
+                if (last - first > mostFrequentCount)
+                {
+                    mostFrequent = first;
+                    mostFrequentCount = last - first;
+                }
+                first = last;
+            }
+
+            defaults.inputs.push_back(column[mostFrequent].second);
+            defaults.exceptionCount += inputCount - mostFrequentCount;
+        }
+
+        return defaults;
+    }
+
+    // Строит разреженную таблицу по найденным значениям по умолчанию;
+    // строковые ячейки создаются только для значений по умолчанию и исключений
+    template <typename Cell, typename GetKey, typename GetCell>
+    SparseTransitionTable<Cell> BuildSparseTable(const size_t stateCount, const size_t inputCount,
+        const ColumnDefaults& defaults, GetKey&& getKey, GetCell&& getCell)
+    {
+        std::vector<Cell> defaultCells;
+        std::vector<size_t> offsets { 0 };
+        std::vector<unsigned> exceptionInputs;
+        std::vector<Cell> exceptionCells;
+        defaultCells.reserve(defaults.inputs.size());
+        offsets.reserve(stateCount + 1);
+        exceptionInputs.reserve(defaults.exceptionCount);
+        exceptionCells.reserve(defaults.exceptionCount);
+
+        for (size_t state = 0; state < stateCount; ++state)
+        {
+            if (inputCount != 0)
+            {
+                const uint32_t defaultInput = defaults.inputs[state];
+                const uint64_t defaultKey = getKey(state, defaultInput);
+                defaultCells.emplace_back(getCell(state, defaultInput));
+                for (unsigned input = 0; input < inputCount; ++input)
+                {
+                    if (getKey(state, input) != defaultKey)
+                    {
+                        exceptionInputs.push_back(input);
+                        exceptionCells.emplace_back(getCell(state, input));
+                    }
+                }
+            }
+            offsets.push_back(exceptionInputs.size());
+        }
+
+        return {
+            inputCount,
+            std::move(defaultCells),
+            std::move(offsets),
+            std::move(exceptionInputs),
+            std::move(exceptionCells)
+        };
+    }
+}
+
+// Собирает индексированный автомат Мили по строкам CSV, заменяя имена индексами сразу
+// при чтении. Пока число строк неизвестно, ячейки хранятся по строкам в 32-битных
+// индексах; Build переставляет таблицу по столбцам в самый узкий подходящий тип индекса.
+class IndexedMealyAutomataBuilder
+{
+public:
+    explicit IndexedMealyAutomataBuilder(const std::vector<std::string>& states)
+    {
+        for (const auto& state: states)
+        {
+            IndexedController::InternState(m_states, state);
+        }
+    }
+
+    void AddRow(std::string inputSymbol, const std::vector<Transition>& transitions)
+    {
+        if (transitions.size() != GetStateCount())
+        {
+            throw std::invalid_argument("Row \"" + inputSymbol + "\" has " + std::to_string(transitions.size())
+                + " transitions, expected " + std::to_string(GetStateCount()));
+        }
+
+        for (const auto& transition: transitions)
+        {
+            m_nextStates.push_back(IndexedController::GetStateIndex(m_states, transition.nextState));
+            m_outputs.push_back(m_outputSymbols.Intern(transition.outputSymbol));
+        }
+        m_inputSymbols.emplace_back(std::move(inputSymbol));
+    }
+
+    [[nodiscard]] size_t GetStateCount() const
+    {
+        return m_states.GetNames().size();
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetInputSymbols() const
+    {
+        return m_inputSymbols;
+    }
+
+    [[nodiscard]] ColumnDefaults FindColumnDefaults() const
+    {
+        return IndexedController::FindColumnDefaults(GetStateCount(), m_inputSymbols.size(),
+            [&](const size_t state, const size_t input) { return GetCellKey(state, input); });
+    }
+
+    [[nodiscard]] SparseTransitionTable<Transition> BuildSparseTable(const ColumnDefaults& defaults) const
+    {
+        const auto& states = m_states.GetNames();
+        const auto& outputSymbols = m_outputSymbols.GetNames();
+
+        return IndexedController::BuildSparseTable<Transition>(GetStateCount(), m_inputSymbols.size(), defaults,
+            [&](const size_t state, const size_t input) { return GetCellKey(state, input); },
+            [&](const size_t state, const size_t input) {
+                const size_t cell = input * GetStateCount() + state;
+                return Transition(states[m_nextStates[cell]], outputSymbols[m_outputs[cell]]);
+            });
+    }
+
+    [[nodiscard]] AnyIndexedMealyAutomata Build()
+    {
+        const size_t stateCount = GetStateCount();
+        const size_t inputCount = m_inputSymbols.size();
+        const auto width = SelectIndexWidth(std::max(stateCount, m_outputSymbols.GetNames().size()));
+
+        return DispatchIndexWidth(width, [&]<typename Index>(std::type_identity<Index>) {
+            auto nextStates = IndexedController::TransposeRows<Index>(std::move(m_nextStates), stateCount, inputCount);
+            auto outputs = IndexedController::TransposeRows<Index>(std::move(m_outputs), stateCount, inputCount);
+
+            return AnyIndexedMealyAutomata(
+                std::in_place_type<IndexedMealyAutomata<Index>>,
+                m_states.ReleaseNames(),
+                std::move(m_inputSymbols),
+                m_outputSymbols.ReleaseNames(),
+                std::move(nextStates),
+                std::move(outputs));
+        });
+    }
+
+private:
+    [[nodiscard]] uint64_t GetCellKey(const size_t state, const size_t input) const
+    {
+        const size_t cell = input * GetStateCount() + state;
+        return uint64_t(m_nextStates[cell]) << 32 | m_outputs[cell];
+    }
+
+    SymbolTable m_states;
+    SymbolTable m_outputSymbols;
+    std::vector<std::string> m_inputSymbols;
+    // Ячейки по строкам: ячейка (input, state) лежит по индексу input * stateCount + state
+    std::vector<uint32_t> m_nextStates;
+    std::vector<uint32_t> m_outputs;
+};
+
+// Собирает индексированный автомат Мура по строкам CSV, как IndexedMealyAutomataBuilder
+class IndexedMooreAutomataBuilder
+{
+public:
+    explicit IndexedMooreAutomataBuilder(const std::vector<std::pair<std::string, std::string>>& statesInfo)
+    {
+        for (const auto& [state, output]: statesInfo)
+        {
+            IndexedController::InternState(m_states, state);
+            m_stateOutputs.push_back(m_outputSymbols.Intern(output));
+        }
+    }
+
+    void AddRow(std::string inputSymbol, const std::vector<std::string>& nextStates)
+    {
+        if (nextStates.size() != GetStateCount())
+        {
+            throw std::invalid_argument("Row \"" + inputSymbol + "\" has " + std::to_string(nextStates.size())
+                + " transitions, expected " + std::to_string(GetStateCount()));
+        }
+
+        for (const auto& nextState: nextStates)
+        {
+            m_nextStates.push_back(IndexedController::GetStateIndex(m_states, nextState));
+        }
+        m_inputSymbols.emplace_back(std::move(inputSymbol));
+    }
+
+    [[nodiscard]] size_t GetStateCount() const
+    {
+        return m_states.GetNames().size();
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetInputSymbols() const
+    {
+        return m_inputSymbols;
+    }
+
+    [[nodiscard]] ColumnDefaults FindColumnDefaults() const
+    {
+        return IndexedController::FindColumnDefaults(GetStateCount(), m_inputSymbols.size(),
+            [&](const size_t state, const size_t input) { return GetCellKey(state, input); });
+    }
+
+    [[nodiscard]] SparseTransitionTable<std::string> BuildSparseTable(const ColumnDefaults& defaults) const
+    {
+        const auto& states = m_states.GetNames();
+
+        return IndexedController::BuildSparseTable<std::string>(GetStateCount(), m_inputSymbols.size(), defaults,
+            [&](const size_t state, const size_t input) { return GetCellKey(state, input); },
+            [&](const size_t state, const size_t input) { return states[GetCellKey(state, input)]; });
+    }
+
+    [[nodiscard]] AnyIndexedMooreAutomata Build()
+    {
+        const size_t stateCount = GetStateCount();
+        const size_t inputCount = m_inputSymbols.size();
+        const auto width = SelectIndexWidth(std::max(stateCount, m_outputSymbols.GetNames().size()));
+
+        return DispatchIndexWidth(width, [&]<typename Index>(std::type_identity<Index>) {
+            auto nextStates = IndexedController::TransposeRows<Index>(std::move(m_nextStates), stateCount, inputCount);
+
+            return AnyIndexedMooreAutomata(
+                std::in_place_type<IndexedMooreAutomata<Index>>,
+                m_states.ReleaseNames(),
+                std::move(m_inputSymbols),
+                m_outputSymbols.ReleaseNames(),
+                NarrowIndexes<Index>(std::move(m_stateOutputs)),
+                std::move(nextStates));
+        });
+    }
+
+private:
+    [[nodiscard]] uint64_t GetCellKey(const size_t state, const size_t input) const
+    {
+        return m_nextStates[input * GetStateCount() + state];
+    }
+
+    SymbolTable m_states;
+    SymbolTable m_outputSymbols;
+    std::vector<std::string> m_inputSymbols;
+    std::vector<uint32_t> m_stateOutputs;
+    // Ячейки по строкам, как в IndexedMealyAutomataBuilder
+    std::vector<uint32_t> m_nextStates;
+};
+
+#endif
@@ -4,76 +4,181 @@
 
 #include <fstream>
 #include <list>
+#include <optional>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "IAutomata.h"
+#include "IndexedAutomata.h"
+#include "SparseTransitionTable.h"
 
 using inputSymbol = std::string;
 using MealyTransitionTable = std::list<std::pair<inputSymbol, std::vector<Transition>>>;
+using SparseMealyTransitionTable = SparseTransitionTable<Transition>;
 using MealyStates = std::vector<std::string>;
 
+// Плотная таблица хранится в индексах самой узкой подходящей ширины,
+// разреженная - в виде значений по умолчанию и исключений
 class MealyAutomata final : public IAutomata
 {
 public:
-    MealyAutomata(MealyStates states, MealyTransitionTable table)
+    MealyAutomata(const MealyStates& states, const MealyTransitionTable& table)
+        : m_indexedAutomata(InternTransitionTable(states, table))
+    {}
+
+    MealyAutomata(MealyStates states, std::vector<inputSymbol> inputSymbols, SparseMealyTransitionTable table)
         : m_states(std::move(states)),
-        m_transitionTable(std::move(table))
+        m_inputSymbols(std::move(inputSymbols)),
+        m_sparseTransitionTable(std::move(table))
     {}
 
-    void ExportToCsv(const std::string &filename) const override
+    explicit MealyAutomata(AnyIndexedMealyAutomata automata)
+        : m_indexedAutomata(std::move(automata))
+    {}
+
+    void ExportToCsv(const std::string &filename, const OutputCompression& compression = {}) const override
     {
-        std::ofstream output(filename);
-        if (!output.is_open())
+        CompressedStream::OutputFile output(filename, compression);
+        if (!output.IsOpen())
         {
             const std::string message = "Could not open file " + filename + " for writing";
             throw std::invalid_argument(message);
         }
 
-        for (const auto& state: m_states)
+        for (const auto& state: GetStates())
         {
             output << ';' << state;
         }
-        output << std::endl;
+        output << '\n';
 
-        for (const auto& [inputSymbol, transitions] : m_transitionTable)
+        if (IsSparse())
         {
-            output << inputSymbol;
+            m_sparseTransitionTable.ForEachRow([&](const unsigned input, const std::vector<const Transition*>& row) {
+                output << m_inputSymbols[input];
+
+                for (const Transition* transition : row)
+                {
+                    output << ';' << transition->nextState << '/' << transition->outputSymbol;
+                }
 
-            for (const Transition& transition : transitions)
+                output << '\n';
+            });
+
+            output.Close();
+            return;
+        }
+
+        std::visit([&](const auto& mealy) {
+            const auto& states = mealy.GetStates();
+            const auto& outputSymbols = mealy.GetOutputSymbols();
+            for (size_t input = 0; input < mealy.GetInputCount(); ++input)
             {
-                output << ';' << transition.nextState << '/' << transition.outputSymbol;
+                output << mealy.GetInputSymbols()[input];
+
+                for (size_t state = 0; state < mealy.GetStateCount(); ++state)
+                {
+                    output << ';' << states[mealy.GetNextStates(state)[input]]
+                        << '/' << outputSymbols[mealy.GetOutputs(state)[input]];
+                }
+
+                output << '\n';
             }
+        }, *m_indexedAutomata);
 
-            output << std::endl;
-        }
+        output.Close();
+    }
+
+    [[nodiscard]] bool IsSparse() const
+    {
+        return !m_indexedAutomata.has_value();
     }
 
+    // Для разреженного автомата таблица разворачивается в плотную
     [[nodiscard]] MealyTransitionTable GetTransitionTable() const
     {
-        return m_transitionTable;
+        MealyTransitionTable transitionTable;
+        if (!IsSparse())
+        {
+            std::visit([&](const auto& mealy) {
+                const auto& states = mealy.GetStates();
+                const auto& outputSymbols = mealy.GetOutputSymbols();
+                for (size_t input = 0; input < mealy.GetInputCount(); ++input)
+                {
+                    std::vector<Transition> transitions;
+                    transitions.reserve(mealy.GetStateCount());
+                    for (size_t state = 0; state < mealy.GetStateCount(); ++state)
+                    {
+                        transitions.emplace_back(states[mealy.GetNextStates(state)[input]],
+                            outputSymbols[mealy.GetOutputs(state)[input]]);
+                    }
+                    transitionTable.emplace_back(mealy.GetInputSymbols()[input], std::move(transitions));
+                }
+            }, *m_indexedAutomata);
+
+            return transitionTable;
+        }
+
+        m_sparseTransitionTable.ForEachRow([&](const unsigned input, const std::vector<const Transition*>& row) {
+            std::vector<Transition> transitions;
+            transitions.reserve(row.size());
+            for (const Transition* transition : row)
+            {
+                transitions.emplace_back(*transition);
+            }
+            transitionTable.emplace_back(m_inputSymbols[input], std::move(transitions));
+        });
+
+        return transitionTable;
+    }
+
+    [[nodiscard]] const AnyIndexedMealyAutomata& GetIndexedAutomata() const
+    {
+        return m_indexedAutomata.value();
     }
 
-    [[nodiscard]] MealyStates GetStates() const
+    [[nodiscard]] const SparseMealyTransitionTable& GetSparseTransitionTable() const
     {
-        return m_states;
+        return m_sparseTransitionTable;
     }
 
-    std::vector<std::string> GetInputSymbols()
+    [[nodiscard]] MealyStates GetStates() const
     {
-        std::vector<std::string> inputSymbols;
+        if (IsSparse())
+        {
+            return m_states;
+        }
 
-        for (auto& it: m_transitionTable)
+        return std::visit([](const auto& mealy) { return mealy.GetStates(); }, *m_indexedAutomata);
+    }
+
+    [[nodiscard]] std::vector<std::string> GetInputSymbols() const
+    {
+        if (IsSparse())
         {
-            inputSymbols.emplace_back(it.first);
+            return m_inputSymbols;
         }
 
-        return inputSymbols;
+        return std::visit([](const auto& mealy) { return mealy.GetInputSymbols(); }, *m_indexedAutomata);
     }
 
 private:
+    static AnyIndexedMealyAutomata InternTransitionTable(const MealyStates& states, const MealyTransitionTable& table)
+    {
+        IndexedMealyAutomataBuilder builder(states);
+        for (const auto& [inputSymbol, transitions]: table)
+        {
+            builder.AddRow(inputSymbol, transitions);
+        }
+
+        return builder.Build();
+    }
+
+    // Используются только для разреженной таблицы
     MealyStates m_states;
-    MealyTransitionTable m_transitionTable;
+    std::vector<inputSymbol> m_inputSymbols;
+    SparseMealyTransitionTable m_sparseTransitionTable;
+    std::optional<AnyIndexedMealyAutomata> m_indexedAutomata;
 };
 
 #endif
\ No newline at end of file
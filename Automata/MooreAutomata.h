@@ -5,72 +5,115 @@
 
 #include <fstream>
 #include <list>
+#include <optional>
+#include <variant>
 #include <vector>
 
 #include "IAutomata.h"
+#include "IndexedAutomata.h"
+#include "SparseTransitionTable.h"
 
 using InputSymbol = std::string;
 using OutputSymbol = std::string;
 using State = std::string;
 using MooreTransitionTable = std::list<std::pair<InputSymbol, std::vector<State>>>;
+using SparseMooreTransitionTable = SparseTransitionTable<State>;
 using MooreStatesInfo = std::vector<std::pair<State, OutputSymbol>>;
 
+// Плотная таблица хранится в индексах самой узкой подходящей ширины,
+// разреженная - в виде значений по умолчанию и исключений
 class MooreAutomata final : public IAutomata
 {
 public:
+    // Входные символы плотной таблицы берутся из её строк
+    MooreAutomata(const MooreStatesInfo& statesInfo, const MooreTransitionTable& transitionTable)
+        : m_indexedAutomata(InternTransitionTable(statesInfo, transitionTable))
+    {}
+
     MooreAutomata(
         std::vector<InputSymbol>&& inputSymbols,
         MooreStatesInfo&& statesInfo,
-        MooreTransitionTable&& transitionTable
+        SparseMooreTransitionTable&& transitionTable
     )
         : m_inputSymbols(std::move(inputSymbols)),
         m_statesInfo(std::move(statesInfo)),
-        m_transitionTable(std::move(transitionTable))
+        m_sparseTransitionTable(std::move(transitionTable))
+    {}
+
+    explicit MooreAutomata(AnyIndexedMooreAutomata automata)
+        : m_indexedAutomata(std::move(automata))
     {}
 
-    void ExportToCsv(const std::string &filename) const override
+    void ExportToCsv(const std::string &filename, const OutputCompression& compression = {}) const override
     {
-        std::ofstream file(filename);
-        if (!file.is_open())
+        CompressedStream::OutputFile file(filename, compression);
+        if (!file.IsOpen())
         {
             throw std::runtime_error("Could not open the file for writing.");
         }
 
-        std::string statesStr, outputSymbolsStr;
-        for (const auto& info : m_statesInfo)
+        const auto statesInfo = GetStatesInfo();
+        std::string line;
+        AppendCsvLine(line, "", statesInfo.size(), [&](const size_t state) -> const std::string& {
+            return statesInfo[state].second;
+        });
+        AppendCsvLine(line, "", statesInfo.size(), [&](const size_t state) -> const std::string& {
+            return statesInfo[state].first;
+        });
+        file << line;
+
+        if (IsSparse())
         {
-            outputSymbolsStr += ';' + info.second;
-            statesStr += ';' + info.first;
+            m_sparseTransitionTable.ForEachRow([&](const unsigned input, const std::vector<const State*>& row) {
+                line.clear();
+                AppendCsvLine(line, m_inputSymbols[input], row.size(), [&](const size_t state) -> const std::string& {
+                    return *row[state];
+                });
+                file << line;
+            });
+
+            file.Close();
+            return;
         }
-        outputSymbolsStr += '\n';
-        statesStr += '\n';
-
-        file << outputSymbolsStr;
-        file << statesStr;
-
-        for (const auto& input : m_inputSymbols)
-        {
-            file << input;
 
-            for (const auto& transitions: m_transitionTable)
+        std::visit([&](const auto& moore) {
+            const auto& states = moore.GetStates();
+            for (size_t input = 0; input < moore.GetInputCount(); ++input)
             {
-                if (transitions.first == input)
-                {
-                    for (const auto& transition : transitions.second)
-                    {
-                        file << ";" << transition;
-                    }
-                    file << "\n";
-                }
+                line.clear();
+                AppendCsvLine(line, moore.GetInputSymbols()[input], moore.GetStateCount(),
+                    [&](const size_t state) -> const std::string& {
+                        return states[moore.GetNextStates(state)[input]];
+                    });
+                file << line;
             }
-        }
+        }, *m_indexedAutomata);
 
-        file.close();
+        file.Close();
+    }
+
+    // Дописывает строку CSV автомата Мура: первую ячейку и cellCount ячеек getCell(i) через ';'.
+    // Используется и при полной записи файла, и при переписывании отдельных строк
+    template <typename GetCell>
+    static void AppendCsvLine(std::string& line, const std::string& first, const size_t cellCount, GetCell&& getCell)
+    {
+        line += first;
+        for (size_t cell = 0; cell < cellCount; ++cell)
+        {
+            line += ';';
+            line += getCell(cell);
+        }
+        line += '\n';
     }
 
     [[nodiscard]] std::vector<std::string> GetInputSymbols() const
     {
-        return m_inputSymbols;
+        if (IsSparse())
+        {
+            return m_inputSymbols;
+        }
+
+        return std::visit([](const auto& moore) { return moore.GetInputSymbols(); }, *m_indexedAutomata);
     }
 
     [[nodiscard]] std::vector<std::string> GetOutputSymbols() const
@@ -80,19 +123,93 @@ public:
 
     [[nodiscard]] MooreStatesInfo GetStatesInfo() const
     {
-        return m_statesInfo;
+        if (IsSparse())
+        {
+            return m_statesInfo;
+        }
+
+        return std::visit([](const auto& moore) {
+            MooreStatesInfo statesInfo;
+            statesInfo.reserve(moore.GetStateCount());
+            for (size_t state = 0; state < moore.GetStateCount(); ++state)
+            {
+                statesInfo.emplace_back(moore.GetStates()[state], moore.GetOutputSymbols()[moore.GetStateOutputs()[state]]);
+            }
+
+            return statesInfo;
+        }, *m_indexedAutomata);
+    }
+
+    [[nodiscard]] bool IsSparse() const
+    {
+        return !m_indexedAutomata.has_value();
     }
 
+    // Для разреженного автомата таблица разворачивается в плотную
     [[nodiscard]] MooreTransitionTable GetTransitionTable() const
     {
-        return m_transitionTable;
+        MooreTransitionTable transitionTable;
+        if (!IsSparse())
+        {
+            std::visit([&](const auto& moore) {
+                const auto& states = moore.GetStates();
+                for (size_t input = 0; input < moore.GetInputCount(); ++input)
+                {
+                    std::vector<State> nextStates;
+                    nextStates.reserve(moore.GetStateCount());
+                    for (size_t state = 0; state < moore.GetStateCount(); ++state)
+                    {
+                        nextStates.emplace_back(states[moore.GetNextStates(state)[input]]);
+                    }
+                    transitionTable.emplace_back(moore.GetInputSymbols()[input], std::move(nextStates));
+                }
+            }, *m_indexedAutomata);
+
+            return transitionTable;
+        }
+
+        m_sparseTransitionTable.ForEachRow([&](const unsigned input, const std::vector<const State*>& row) {
+            std::vector<State> states;
+            states.reserve(row.size());
+            for (const State* state : row)
+            {
+                states.emplace_back(*state);
+            }
+            transitionTable.emplace_back(m_inputSymbols[input], std::move(states));
+        });
+
+        return transitionTable;
+    }
+
+    [[nodiscard]] const AnyIndexedMooreAutomata& GetIndexedAutomata() const
+    {
+        return m_indexedAutomata.value();
+    }
+
+    [[nodiscard]] const SparseMooreTransitionTable& GetSparseTransitionTable() const
+    {
+        return m_sparseTransitionTable;
     }
 
 private:
+    static AnyIndexedMooreAutomata InternTransitionTable(const MooreStatesInfo& statesInfo,
+        const MooreTransitionTable& table)
+    {
+        IndexedMooreAutomataBuilder builder(statesInfo);
+        for (const auto& [inputSymbol, nextStates]: table)
+        {
+            builder.AddRow(inputSymbol, nextStates);
+        }
+
+        return builder.Build();
+    }
+
+    // Используются только для разреженной таблицы
     std::vector<std::string> m_inputSymbols;
-    std::vector<std::string> m_outputSymbols;
     MooreStatesInfo m_statesInfo;
-    MooreTransitionTable m_transitionTable;
+    SparseMooreTransitionTable m_sparseTransitionTable;
+    std::vector<std::string> m_outputSymbols;
+    std::optional<AnyIndexedMooreAutomata> m_indexedAutomata;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,373 @@
+#pragma once
+
+#ifndef SPARSE_TRANSITION_TABLE_H
+#define SPARSE_TRANSITION_TABLE_H
+
+#include <algorithm>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Во сколько ячеек плотной таблицы обходится при переводе одна хранимая ячейка разреженной:
+// по mealy_moore_benchmark разреженный перевод медленнее в 30-80 раз на ячейку. Автоматический
+// выбор переходит к разреженному виду, только если он дешевле и при худшем соотношении
+constexpr size_t SPARSE_CELL_COST = 80;
+
+enum class TableStorage
+{
+    Auto,
+    Dense,
+    Sparse
+};
+
+// Таблица переходов, хранящая для каждого состояния (столбца) переход по умолчанию
+// и список исключений в формате CSR: исключения состояния s лежат в диапазоне
+// [offsets[s], offsets[s + 1]) и отсортированы по индексу входного символа.
+// В таблице без входных символов нет ни одной ячейки, поэтому нет и значений по умолчанию.
+template <typename Cell>
+class SparseTransitionTable
+{
+public:
+    SparseTransitionTable() = default;
+
+    SparseTransitionTable(
+        const size_t inputCount,
+        std::vector<Cell>&& defaults,
+        std::vector<size_t>&& offsets,
+        std::vector<unsigned>&& exceptionInputs,
+        std::vector<Cell>&& exceptionCells
+    )
+        : m_inputCount(inputCount),
+        m_defaults(std::move(defaults)),
+        m_offsets(std::move(offsets)),
+        m_exceptionInputs(std::move(exceptionInputs)),
+        m_exceptionCells(std::move(exceptionCells))
+    {
+        const size_t expectedDefaults = m_inputCount == 0 || m_offsets.empty() ? 0 : m_offsets.size() - 1;
+        if (m_offsets.empty() || m_defaults.size() != expectedDefaults
+            || m_exceptionInputs.size() != m_exceptionCells.size())
+        {
+            throw std::invalid_argument("Inconsistent sparse transition table");
+        }
+    }
+
+    [[nodiscard]] size_t GetInputCount() const
+    {
+        return m_inputCount;
+    }
+
+    [[nodiscard]] size_t GetStateCount() const
+    {
+        return m_offsets.size() - 1;
+    }
+
+    [[nodiscard]] size_t GetExceptionCount() const
+    {
+        return m_exceptionCells.size();
+    }
+
+    [[nodiscard]] double GetDensity() const
+    {
+        const size_t cellCount = m_inputCount * GetStateCount();
+        return cellCount == 0 ? 0.0 : static_cast<double>(m_exceptionCells.size()) / static_cast<double>(cellCount);
+    }
+
+    [[nodiscard]] bool HasDefaults() const
+    {
+        return m_inputCount != 0;
+    }
+
+    [[nodiscard]] const Cell& GetDefault(const size_t state) const
+    {
+        return m_defaults.at(state);
+    }
+
+    // Первый вход, на котором столбец принимает значение по умолчанию; он же равен числу
+    // исключений перед ним. Если исключениями заняты все входы, возвращается их число
+    [[nodiscard]] size_t GetFirstDefaultInput(const size_t state) const
+    {
+        const auto inputs = GetExceptionInputs(state);
+        size_t input = 0;
+        while (input < inputs.size() && inputs[input] == input)
+        {
+            ++input;
+        }
+
+        return input;
+    }
+
+    // Вызывает callback для значения по умолчанию и каждого исключения состояния
+    template <typename Callback>
+    void ForEachStoredCell(const size_t state, Callback&& callback) const
+    {
+        if (HasDefaults())
+        {
+            callback(m_defaults.at(state));
+        }
+        for (const auto& cell: GetExceptionCells(state))
+        {
+            callback(cell);
+        }
+    }
+
+    [[nodiscard]] std::span<const unsigned> GetExceptionInputs(const size_t state) const
+    {
+        return { m_exceptionInputs.data() + m_offsets[state], m_offsets[state + 1] - m_offsets[state] };
+    }
+
+    [[nodiscard]] std::span<const Cell> GetExceptionCells(const size_t state) const
+    {
+        return { m_exceptionCells.data() + m_offsets[state], m_offsets[state + 1] - m_offsets[state] };
+    }
+
+    [[nodiscard]] const Cell& Get(const size_t input, const size_t state) const
+    {
+        const auto inputs = GetExceptionInputs(state);
+        const auto it = std::lower_bound(inputs.begin(), inputs.end(), input);
+        if (it != inputs.end() && *it == input)
+        {
+            return GetExceptionCells(state)[it - inputs.begin()];
+        }
+
+        return m_defaults.at(state);
+    }
+
+    // Обходит таблицу построчно (по входным символам), не разворачивая её целиком
+    template <typename Callback>
+    void ForEachRow(Callback&& callback) const
+    {
+        std::vector<size_t> cursors(m_offsets.begin(), m_offsets.end() - 1);
+        std::vector<const Cell*> row(GetStateCount());
+
+        for (unsigned input = 0; input < m_inputCount; ++input)
+        {
+            for (size_t state = 0; state < row.size(); ++state)
+            {
+                size_t& cursor = cursors[state];
+                if (cursor < m_offsets[state + 1] && m_exceptionInputs[cursor] == input)
+                {
+                    row[state] = &m_exceptionCells[cursor++];
+                }
+                else
+                {
+                    row[state] = &m_defaults[state];
+                }
+            }
+
+            callback(input, row);
+        }
+    }
+
+    // Возвращает таблицу той же структуры, в которой каждая ячейка преобразована функцией
+    template <typename Function>
+    [[nodiscard]] auto Map(Function&& function) const
+    {
+        using MappedCell = std::decay_t<decltype(function(std::declval<const Cell&>()))>;
+
+        std::vector<MappedCell> defaults;
+        defaults.reserve(m_defaults.size());
+        for (const auto& cell: m_defaults)
+        {
+            defaults.emplace_back(function(cell));
+        }
+
+        std::vector<MappedCell> exceptionCells;
+        exceptionCells.reserve(m_exceptionCells.size());
+        for (const auto& cell: m_exceptionCells)
+        {
+            exceptionCells.emplace_back(function(cell));
+        }
+
+        auto offsets = m_offsets;
+        auto exceptionInputs = m_exceptionInputs;
+
+        return SparseTransitionTable<MappedCell>(
+            m_inputCount,
+            std::move(defaults),
+            std::move(offsets),
+            std::move(exceptionInputs),
+            std::move(exceptionCells));
+    }
+
+    // Возвращает таблицу только с указанными состояниями (столбцами) в заданном порядке
+    [[nodiscard]] SparseTransitionTable SelectStates(const std::vector<unsigned>& states) const
+    {
+        std::vector<Cell> defaults;
+        std::vector<size_t> offsets { 0 };
+        std::vector<unsigned> exceptionInputs;
+        std::vector<Cell> exceptionCells;
+        defaults.reserve(states.size());
+        offsets.reserve(states.size() + 1);
+
+        for (const auto state: states)
+        {
+            if (HasDefaults())
+            {
+                defaults.push_back(m_defaults.at(state));
+            }
+
+            const auto inputs = GetExceptionInputs(state);
+            const auto cells = GetExceptionCells(state);
+            exceptionInputs.insert(exceptionInputs.end(), inputs.begin(), inputs.end());
+            exceptionCells.insert(exceptionCells.end(), cells.begin(), cells.end());
+            offsets.push_back(exceptionInputs.size());
+        }
+
+        return {
+            m_inputCount,
+            std::move(defaults),
+            std::move(offsets),
+            std::move(exceptionInputs),
+            std::move(exceptionCells)
+        };
+    }
+
+private:
+    size_t m_inputCount = 0;
+    std::vector<Cell> m_defaults;
+    std::vector<size_t> m_offsets { 0 };
+    std::vector<unsigned> m_exceptionInputs;
+    std::vector<Cell> m_exceptionCells;
+};
+
+// Собирает разреженную таблицу построчно, по мере чтения CSV.
+// Предварительным значением по умолчанию считается ячейка первой строки,
+// при сборке оно заменяется самым частым значением столбца.
+template <typename Cell>
+class SparseTransitionTableBuilder
+{
+public:
+    explicit SparseTransitionTableBuilder(const size_t stateCount)
+        : m_stateCount(stateCount),
+        m_columns(stateCount)
+    {}
+
+    void AddRow(std::vector<Cell>&& row)
+    {
+        if (row.size() != m_stateCount)
+        {
+            const std::string message = "Row " + std::to_string(m_inputCount + 1) + " has "
+                + std::to_string(row.size()) + " transitions, expected " + std::to_string(m_stateCount);
+            throw std::invalid_argument(message);
+        }
+
+        if (m_inputCount == 0)
+        {
+            m_defaults = std::move(row);
+        }
+        else
+        {
+            for (size_t state = 0; state < m_stateCount; ++state)
+            {
+                if (!(row[state] == m_defaults[state]))
+                {
+                    m_columns[state].emplace_back(m_inputCount, std::move(row[state]));
+                    ++m_exceptionCount;
+                }
+            }
+        }
+
+        ++m_inputCount;
+    }
+
+    [[nodiscard]] size_t GetInputCount() const
+    {
+        return m_inputCount;
+    }
+
+    [[nodiscard]] SparseTransitionTable<Cell> Build()
+    {
+        m_exceptionCount = 0;
+        for (size_t state = 0; state < m_stateCount; ++state)
+        {
+            ChooseMostFrequentDefault(state);
+            m_exceptionCount += m_columns[state].size();
+        }
+
+        std::vector<size_t> offsets { 0 };
+        std::vector<unsigned> exceptionInputs;
+        std::vector<Cell> exceptionCells;
+        offsets.reserve(m_stateCount + 1);
+        exceptionInputs.reserve(m_exceptionCount);
+        exceptionCells.reserve(m_exceptionCount);
+
+        for (auto& column: m_columns)
+        {
+            for (auto& [input, cell]: column)
+            {
+                exceptionInputs.push_back(input);
+                exceptionCells.emplace_back(std::move(cell));
+            }
+            offsets.push_back(exceptionInputs.size());
+            column = {};
+        }
+
+        return {
+            m_inputCount,
+            std::move(m_defaults),
+            std::move(offsets),
+            std::move(exceptionInputs),
+            std::move(exceptionCells)
+        };
+    }
+
+private:
+    void ChooseMostFrequentDefault(const size_t state)
+    {
+        auto& column = m_columns[state];
+
+        std::map<Cell, unsigned> counts;
+        const Cell* mostFrequent = nullptr;
+        unsigned mostFrequentCount = 0;
+        for (const auto& [input, cell]: column)
+        {
+            const unsigned count = ++counts[cell];
+            if (count > mostFrequentCount)
+            {
+                mostFrequent = &cell;
+                mostFrequentCount = count;
+            }
+        }
+
+        if (mostFrequent == nullptr || mostFrequentCount <= m_inputCount - column.size())
+        {
+            return;
+        }
+
+        Cell newDefault = *mostFrequent;
+        std::vector<std::pair<unsigned, Cell>> newColumn;
+        newColumn.reserve(m_inputCount - mostFrequentCount);
+
+        auto it = column.begin();
+        for (unsigned input = 0; input < m_inputCount; ++input)
+        {
+            if (it != column.end() && it->first == input)
+            {
+                if (!(it->second == newDefault))
+                {
+                    newColumn.emplace_back(input, std::move(it->second));
+                }
+                ++it;
+            }
+            else
+            {
+                newColumn.emplace_back(input, m_defaults[state]);
+            }
+        }
+
+        m_defaults[state] = std::move(newDefault);
+        column = std::move(newColumn);
+    }
+
+    size_t m_stateCount;
+    size_t m_inputCount = 0;
+    size_t m_exceptionCount = 0;
+    std::vector<Cell> m_defaults;
+    std::vector<std::vector<std::pair<unsigned, Cell>>> m_columns;
+};
+
+#endif
@@ -11,7 +11,7 @@
 
 namespace MealyController
 {
-    inline std::vector<std::string> GetStatesFromFile(std::ifstream& inputFile)
+    inline std::vector<std::string> GetStatesFromFile(std::istream& inputFile)
     {
         std::vector<std::string> states;
 
@@ -31,57 +31,109 @@ namespace MealyController
         return states;
     }
 
-    inline MealyTransitionTable GetTransitionsFromFile(std::ifstream& inputFile, std::vector<std::string>& states)
+    inline std::pair<inputSymbol, std::vector<Transition>> GetTransitionsFromLine(const std::string& line,
+        const std::vector<std::string>& states)
     {
-        MealyTransitionTable transitionTable;
-
-        std::string line;
-        while (std::getline(inputFile, line))
-        {
-            std::stringstream ss(line);
-            std::string inputSymbol;
-            std::getline(ss, inputSymbol, ';');
+        std::stringstream ss(line);
+        std::string inputSymbol;
+        std::getline(ss, inputSymbol, ';');
 
-            std::vector<Transition> transitions;
+        std::vector<Transition> transitions;
+        transitions.reserve(states.size());
 
-            for (const auto& state : states)
+        for (size_t index = 0; index < states.size(); ++index)
+        {
+            std::string transitionData;
+            if (std::getline(ss, transitionData, ';'))
             {
-                std::string transitionData;
-                if (std::getline(ss, transitionData, ';'))
+                size_t separatorPos = transitionData.find('/');
+                if (separatorPos != std::string::npos)
                 {
-                    size_t separatorPos = transitionData.find('/');
-                    if (separatorPos != std::string::npos)
-                    {
-                        std::string nextState = transitionData.substr(0, separatorPos);
-                        std::string output = transitionData.substr(separatorPos + 1);
-
-                        transitions.emplace_back(nextState, output);
-                    }
+                    std::string nextState = transitionData.substr(0, separatorPos);
+                    std::string output = transitionData.substr(separatorPos + 1);
+
+                    transitions.emplace_back(nextState, output);
                 }
             }
+        }
 
-            transitionTable.emplace_back(inputSymbol, transitions);
+        return { inputSymbol, transitions };
+    }
+
+    inline MealyTransitionTable GetTransitionsFromFile(std::istream& inputFile, std::vector<std::string>& states)
+    {
+        MealyTransitionTable transitionTable;
+
+        std::string line;
+        while (std::getline(inputFile, line))
+        {
+            transitionTable.emplace_back(GetTransitionsFromLine(line, states));
         }
 
         return transitionTable;
     }
 
-    inline std::unique_ptr<MealyAutomata> GetMealyAutomataFromCsvFile(const std::string &inputFilename)
+    inline std::pair<std::vector<inputSymbol>, SparseMealyTransitionTable> GetSparseTransitionsFromFile(
+        std::istream& inputFile, std::vector<std::string>& states)
     {
-        std::ifstream input(inputFilename);
-        if (!input.is_open())
+        std::vector<inputSymbol> inputSymbols;
+        SparseTransitionTableBuilder<Transition> builder(states.size());
+
+        std::string line;
+        while (std::getline(inputFile, line))
+        {
+            auto [inputSymbol, transitions] = GetTransitionsFromLine(line, states);
+            inputSymbols.emplace_back(std::move(inputSymbol));
+            builder.AddRow(std::move(transitions));
+        }
+
+        return { std::move(inputSymbols), builder.Build() };
+    }
+
+    inline std::unique_ptr<MealyAutomata> GetMealyAutomataFromCsvFile(const std::string &inputFilename,
+        const TableStorage storage = TableStorage::Auto)
+    {
+        CompressedStream::InputFile input(inputFilename);
+        if (!input.IsOpen())
         {
             std::string message = "File \"" + inputFilename + "\" not found";
             throw std::runtime_error(message);
         }
 
         std::vector<std::string> states = GetStatesFromFile(input);
-        MealyTransitionTable transitions = GetTransitionsFromFile(input, states);
 
-        input.close();
+        if (storage == TableStorage::Sparse)
+        {
+            auto [inputSymbols, sparseTransitions] = GetSparseTransitionsFromFile(input, states);
+
+            return std::make_unique<MealyAutomata>(
+                std::move(states), std::move(inputSymbols), std::move(sparseTransitions));
+        }
 
-        MealyAutomata mealy(std::move(states), std::move(transitions));
-        return std::make_unique<MealyAutomata>(mealy);
+        // Имена заменяются индексами сразу при чтении; строковые ячейки создаются,
+        // только если таблица оказалась разреженной
+        IndexedMealyAutomataBuilder builder(states);
+        std::string line;
+        while (std::getline(input, line))
+        {
+            auto [inputSymbol, transitions] = GetTransitionsFromLine(line, states);
+            builder.AddRow(std::move(inputSymbol), transitions);
+        }
+
+        // Одни значения по умолчанию занимают 1/inputCount ячеек, поэтому при малом алфавите
+        // разреженный вид не может оказаться дешевле и столбцы не разбираются
+        if (storage == TableStorage::Auto && builder.GetInputSymbols().size() >= SPARSE_CELL_COST)
+        {
+            const auto defaults = builder.FindColumnDefaults();
+            if (defaults.IsSparseCheaper())
+            {
+                auto inputSymbols = builder.GetInputSymbols();
+                return std::make_unique<MealyAutomata>(
+                    std::move(states), std::move(inputSymbols), builder.BuildSparseTable(defaults));
+            }
+        }
+
+        return std::make_unique<MealyAutomata>(builder.Build());
     }
 }
 
@@ -129,16 +181,55 @@ namespace MooreController
         return states;
     }
 
-    inline std::unique_ptr<MooreAutomata> GetMooreAutomataFromCsvFile(const std::string& filename)
+    inline std::pair<InputSymbol, std::vector<State>> GetTransitionsFromLine(const std::string& line)
+    {
+        std::stringstream ss(line);
+        std::string inputSymbol;
+        std::getline(ss, inputSymbol, ';');
+
+        std::vector<std::string> stateTransitions;
+        std::string transition;
+        while (std::getline(ss, transition, ';'))
+        {
+            if (!transition.empty())
+            {
+                stateTransitions.push_back(transition);
+            }
+        }
+
+        return { inputSymbol, stateTransitions };
+    }
+
+    inline std::unique_ptr<MooreAutomata> GetSparseMooreAutomataFromCsvFile(std::istream& file,
+        std::vector<InputSymbol>&& inputSymbols, MooreStatesInfo&& states)
     {
-        std::list<std::pair<std::string, std::vector<std::string>>> transitionTable;
+        SparseTransitionTableBuilder<State> builder(states.size());
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty())
+            {
+                continue;
+            }
 
+            auto [inputSymbol, stateTransitions] = GetTransitionsFromLine(line);
+            inputSymbols.push_back(inputSymbol);
+            builder.AddRow(std::move(stateTransitions));
+        }
+
+        return std::make_unique<MooreAutomata>(std::move(inputSymbols), std::move(states), builder.Build());
+    }
+
+    inline std::unique_ptr<MooreAutomata> GetMooreAutomataFromCsvFile(const std::string& filename,
+        const TableStorage storage = TableStorage::Auto)
+    {
         std::vector<std::string> inputSymbols;
         std::vector<std::string> outputSymbols;
         MooreStatesInfo states;
 
-        std::ifstream file(filename);
-        if (!file.is_open())
+        CompressedStream::InputFile file(filename);
+        if (!file.IsOpen())
         {
             throw std::runtime_error("Could not open the file.");
         }
@@ -149,27 +240,35 @@ namespace MooreController
 
         states = GetStatesFromFile(file, outputSymbols);
 
+        if (storage == TableStorage::Sparse)
+        {
+            return GetSparseMooreAutomataFromCsvFile(file, std::move(inputSymbols), std::move(states));
+        }
+
         // Чтение таблицы переходов
+        IndexedMooreAutomataBuilder builder(states);
         while (std::getline(file, line))
         {
-            std::stringstream ss(line);
-            std::string inputSymbol;
-            if (std::getline(ss, inputSymbol, ';'))
+            if (line.empty())
             {
-                std::vector<std::string> stateTransitions;
-                std::string transition;
-                while (std::getline(ss, transition, ';'))
-                {
-                    if (!transition.empty())
-                    {
-                        stateTransitions.push_back(transition);
-                    }
-                }
-                inputSymbols.push_back(inputSymbol);
-                transitionTable.emplace_back(inputSymbol, stateTransitions);
+                continue;
             }
+
+            auto [inputSymbol, stateTransitions] = GetTransitionsFromLine(line);
+            builder.AddRow(std::move(inputSymbol), stateTransitions);
         }
-        MooreAutomata mooreAutomata(std::move(inputSymbols), std::move(states), std::move(transitionTable));
-        return std::make_unique<MooreAutomata>(mooreAutomata);
+
+        if (storage == TableStorage::Auto && builder.GetInputSymbols().size() >= SPARSE_CELL_COST)
+        {
+            const auto defaults = builder.FindColumnDefaults();
+            if (defaults.IsSparseCheaper())
+            {
+                inputSymbols = builder.GetInputSymbols();
+                return std::make_unique<MooreAutomata>(
+                    std::move(inputSymbols), std::move(states), builder.BuildSparseTable(defaults));
+            }
+        }
+
+        return std::make_unique<MooreAutomata>(builder.Build());
     }
 }
\ No newline at end of file
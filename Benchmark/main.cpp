@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "../Converter/IndexedConversion.h"
+#include "../Converter/MealyToMooreConverter.h"
+
+struct MachineParams
+{
+    unsigned stateCount;
+    unsigned inputCount;
+    unsigned outputCount;
+    // Доля состояний, достижимых из стартового
+    double reachableRatio;
+    // Доля ячеек, ведущих в общее состояние-сток с одинаковым выходом
+    double sinkRatio;
+};
+
+constexpr unsigned REPEAT_COUNT = 5;
+constexpr unsigned SEED = 42;
+
+std::unique_ptr<MealyAutomata> GenerateMealyAutomata(const MachineParams& params, const TableStorage storage)
+{
+    std::mt19937 random(SEED);
+    const unsigned reachableCount = std::max(1u, static_cast<unsigned>(params.stateCount * params.reachableRatio));
+
+    MealyStates states;
+    for (unsigned index = 0; index < params.stateCount; ++index)
+    {
+        states.emplace_back("S" + std::to_string(index));
+    }
+
+    // Достижимые состояния переходят только друг в друга, остальные - куда угодно
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    auto getTransition = [&](const unsigned state) {
+        if (chance(random) < params.sinkRatio)
+        {
+            return Transition(states[0], "e");
+        }
+
+        const unsigned bound = state < reachableCount ? reachableCount : params.stateCount;
+        return Transition(
+            states[std::uniform_int_distribution<unsigned>(0, bound - 1)(random)],
+            std::to_string(std::uniform_int_distribution<unsigned>(0, params.outputCount - 1)(random)));
+    };
+
+    auto getRow = [&] {
+        std::vector<Transition> row;
+        row.reserve(params.stateCount);
+        for (unsigned state = 0; state < params.stateCount; ++state)
+        {
+            row.emplace_back(getTransition(state));
+        }
+
+        return row;
+    };
+
+    if (storage == TableStorage::Sparse)
+    {
+        std::vector<inputSymbol> inputSymbols;
+        SparseTransitionTableBuilder<Transition> builder(params.stateCount);
+        for (unsigned input = 0; input < params.inputCount; ++input)
+        {
+            inputSymbols.emplace_back("x" + std::to_string(input));
+            builder.AddRow(getRow());
+        }
+
+        return std::make_unique<MealyAutomata>(std::move(states), std::move(inputSymbols), builder.Build());
+    }
+
+    // Плотный и автоматический выбор строятся так же, как при чтении из файла
+    IndexedMealyAutomataBuilder builder(states);
+    for (unsigned input = 0; input < params.inputCount; ++input)
+    {
+        builder.AddRow("x" + std::to_string(input), getRow());
+    }
+
+    if (storage == TableStorage::Auto && builder.GetInputSymbols().size() >= SPARSE_CELL_COST)
+    {
+        const auto defaults = builder.FindColumnDefaults();
+        if (defaults.IsSparseCheaper())
+        {
+            auto inputSymbols = builder.GetInputSymbols();
+            return std::make_unique<MealyAutomata>(
+                std::move(states), std::move(inputSymbols), builder.BuildSparseTable(defaults));
+        }
+    }
+
+    return std::make_unique<MealyAutomata>(builder.Build());
+}
+
+// Медиана времени выполнения action; prepare в замер не входит
+double MeasureMilliseconds(const std::function<void()>& prepare, const std::function<void()>& action)
+{
+    std::vector<double> times;
+    for (unsigned repeat = 0; repeat < REPEAT_COUNT; ++repeat)
+    {
+        prepare();
+        const auto start = std::chrono::steady_clock::now();
+        action();
+        const auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// autoStorage - вид, который выбрал бы автоматический выбор при чтении того же автомата
+void BenchmarkMooreConstruction(const MachineParams& params, const TableStorage storage, const TableStorage autoStorage)
+{
+    const auto mealy = GenerateMealyAutomata(params, storage);
+
+    for (const auto construction: { MooreConstruction::Full, MooreConstruction::Reachable })
+    {
+        std::unique_ptr<MealyToMooreConverter> converter;
+        size_t mooreStateCount = 0;
+        const double milliseconds = MeasureMilliseconds(
+            [&] {
+                converter = std::make_unique<MealyToMooreConverter>(std::make_unique<MealyAutomata>(*mealy), construction);
+            },
+            [&] {
+                mooreStateCount = converter->GetMooreAutomata()->GetStatesInfo().size();
+            });
+
+        std::cout << std::setw(7) << params.stateCount
+            << std::setw(7) << params.inputCount
+            << std::setw(11) << params.reachableRatio
+            << std::setw(7) << params.sinkRatio
+            << std::setw(8) << (storage == TableStorage::Sparse ? "sparse" : "dense")
+            << std::setw(6) << (storage == autoStorage ? "*" : "")
+            << std::setw(11) << (construction == MooreConstruction::Full ? "full" : "reachable")
+            << std::setw(10) << mooreStateCount
+            << std::setw(12) << milliseconds << '\n';
+    }
+}
+
+const char* GetIndexWidthName(const IndexWidth width)
+{
+    switch (width)
+    {
+        case IndexWidth::UInt8:
+            return "uint8";
+        case IndexWidth::UInt16:
+            return "uint16";
+        default:
+            return "uint32";
+    }
+}
+
+// Сравнивает ядра перевода на одном и том же автомате при разной ширине индексов.
+// Перевод Мили -> Мура измеряется для ширин, в которые помещается автомат Мили,
+// перевод Мура -> Мили - для ширин, в которые помещается автомат Мура
+void BenchmarkIndexWidths(const MachineParams& params)
+{
+    const auto mealy = GenerateMealyAutomata(params, TableStorage::Dense);
+    const auto indexedMealy = std::visit([](const auto& loaded) {
+        auto copy = loaded;
+        return IndexedMealyAutomata<uint32_t>(std::move(copy));
+    }, mealy->GetIndexedAutomata());
+    const auto mealyWidth = SelectIndexWidth(
+        std::max(indexedMealy.GetStateCount(), indexedMealy.GetOutputSymbols().size()));
+
+    const IndexedConversion::MealyToMooreKernel<uint32_t> probe(indexedMealy);
+    const auto mooreWidth = SelectIndexWidth(probe.GetRequiredIndexCount());
+    const auto indexedMoore = probe.Build<uint32_t>(MealyToMooreConverter::STATE_CHAR);
+
+    for (const auto width: { IndexWidth::UInt8, IndexWidth::UInt16, IndexWidth::UInt32 })
+    {
+        if (width < mealyWidth && width < mooreWidth)
+        {
+            continue;
+        }
+
+        DispatchIndexWidth(width, [&]<typename Index>(std::type_identity<Index>) {
+            std::cout << std::setw(7) << params.stateCount
+                << std::setw(7) << params.inputCount
+                << std::setw(8) << GetIndexWidthName(width)
+                << std::setw(12) << (indexedMealy.GetStateCount() * indexedMealy.GetInputCount() * 2 * sizeof(Index)) / 1024;
+
+            if (width >= mealyWidth)
+            {
+                // Ширина автомата Мура выбирается так же, как в MealyToMooreConverter
+                std::unique_ptr<IndexedMealyAutomata<Index>> narrowMealy;
+                const double mealyToMoore = MeasureMilliseconds(
+                    [&] {
+                        auto copy = indexedMealy;
+                        narrowMealy = std::make_unique<IndexedMealyAutomata<Index>>(std::move(copy));
+                    },
+                    [&] {
+                        const IndexedConversion::MealyToMooreKernel<Index> kernel(*narrowMealy);
+                        DispatchIndexWidth(mooreWidth, [&]<typename MooreIndex>(std::type_identity<MooreIndex>) {
+                            [[maybe_unused]] const auto moore = kernel.template Build<MooreIndex>('q');
+                        });
+                    });
+                std::cout << std::setw(15) << mealyToMoore;
+            }
+            else
+            {
+                std::cout << std::setw(15) << "-";
+            }
+
+            if (width >= mooreWidth)
+            {
+                std::unique_ptr<IndexedMooreAutomata<Index>> narrowMoore;
+                const double mooreToMealy = MeasureMilliseconds(
+                    [&] {
+                        auto copy = indexedMoore;
+                        narrowMoore = std::make_unique<IndexedMooreAutomata<Index>>(std::move(copy));
+                    },
+                    [&] {
+                        [[maybe_unused]] const auto result = IndexedConversion::ConvertMooreToMealy(*narrowMoore, 'F');
+                    });
+                std::cout << std::setw(15) << mooreToMealy;
+            }
+            else
+            {
+                std::cout << std::setw(15) << "-";
+            }
+
+            std::cout << '\n';
+        });
+    }
+}
+
+int main()
+{
+    const std::vector<MachineParams> machines = {
+        { 1000, 50, 4, 1.0, 0.0 },
+        { 1000, 50, 4, 0.1, 0.0 },
+        { 5000, 100, 4, 0.05, 0.0 },
+        { 5000, 100, 4, 0.05, 0.9 },
+        { 20000, 200, 8, 0.01, 0.95 },
+        { 20000, 300, 4, 1.0, 0.95 },
+        { 20000, 300, 4, 1.0, 0.99 },
+        { 2000, 2000, 4, 1.0, 0.99 },
+        { 500, 20000, 4, 1.0, 0.999 },
+    };
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << " states inputs reachable   sink storage  auto  construct moore-sts   median-ms\n";
+    for (const auto& machine: machines)
+    {
+        const auto autoStorage = GenerateMealyAutomata(machine, TableStorage::Auto)->IsSparse()
+            ? TableStorage::Sparse
+            : TableStorage::Dense;
+        BenchmarkMooreConstruction(machine, TableStorage::Dense, autoStorage);
+        BenchmarkMooreConstruction(machine, TableStorage::Sparse, autoStorage);
+    }
+
+    const std::vector<MachineParams> smallMachines = {
+        { 60, 4000, 4, 1.0, 0.0 },
+        { 200, 2000, 2, 1.0, 0.0 },
+        { 4000, 500, 8, 1.0, 0.0 },
+    };
+
+    std::cout << "\n states inputs   width  mealy-kib mealy-moore-ms moore-mealy-ms\n";
+    for (const auto& machine: smallMachines)
+    {
+        BenchmarkIndexWidths(machine);
+    }
+
+    return 0;
+}
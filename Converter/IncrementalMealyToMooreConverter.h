@@ -0,0 +1,725 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "IndexedConversion.h"
+#include "MealyToMooreConverter.h"
+#include "../AutomataController.h"
+#include "../Stream/CompressedStream.h"
+
+// Индекс предыдущего перевода, который хранится рядом с файлом автомата Мура
+struct IncrementalIndex
+{
+    static constexpr uint32_t EMPTY_OUTPUT = UINT32_MAX;
+
+    uint64_t headerHash = 0;
+    std::vector<uint64_t> rowHashes;
+    std::vector<std::string> states;
+    std::vector<std::string> inputSymbols;
+    std::vector<std::string> outputSymbols;
+    // Таблица Мили по столбцам, как в IndexedMealyAutomata
+    std::vector<uint32_t> nextStates;
+    std::vector<uint32_t> outputs;
+    std::vector<uint8_t> isReachable;
+    // Состояние Мура с номером i соответствует паре (pairStates[i], pairOutputs[i]);
+    // pairCounts[i] - сколько ячеек достижимых состояний ведут в эту пару
+    std::vector<uint32_t> pairStates;
+    std::vector<uint32_t> pairOutputs;
+    std::vector<uint32_t> pairCounts;
+    // Смещения строк в файле автомата Мура: две строки заголовка, строки переходов и конец файла
+    std::vector<uint64_t> lineOffsets;
+    // Хеши строк файла автомата Мура, чтобы не исправлять файл, перезаписанный другой программой
+    std::vector<uint64_t> lineHashes;
+};
+
+struct IncrementalResult
+{
+    bool isFullConversion = false;
+    std::string fullConversionReason;
+    size_t changedRows = 0;
+    size_t rewrittenRows = 0;
+    bool isRewrittenInPlace = true;
+};
+
+namespace IncrementalIndexFile
+{
+    constexpr char MAGIC[] = "MMIDX002";
+
+    template <typename T>
+    void Write(std::ostream& output, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void Write(std::ostream& output, const std::vector<T>& values)
+    {
+        Write(output, static_cast<uint64_t>(values.size()));
+        output.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+
+    inline void Write(std::ostream& output, const std::vector<std::string>& values)
+    {
+        Write(output, static_cast<uint64_t>(values.size()));
+        for (const auto& value: values)
+        {
+            Write(output, static_cast<uint64_t>(value.size()));
+            output.write(value.data(), static_cast<std::streamsize>(value.size()));
+        }
+    }
+
+    template <typename T>
+    void Read(std::istream& input, T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (!input.read(reinterpret_cast<char*>(&value), sizeof(T)))
+        {
+            throw std::runtime_error("Incremental index is truncated");
+        }
+    }
+
+    template <typename T>
+    void Read(std::istream& input, std::vector<T>& values)
+    {
+        uint64_t size = 0;
+        Read(input, size);
+        values.resize(size);
+        if (!input.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(size * sizeof(T))))
+        {
+            throw std::runtime_error("Incremental index is truncated");
+        }
+    }
+
+    inline void Read(std::istream& input, std::vector<std::string>& values)
+    {
+        uint64_t size = 0;
+        Read(input, size);
+        values.resize(size);
+        for (auto& value: values)
+        {
+            uint64_t length = 0;
+            Read(input, length);
+            value.resize(length);
+            if (!input.read(value.data(), static_cast<std::streamsize>(length)))
+            {
+                throw std::runtime_error("Incremental index is truncated");
+            }
+        }
+    }
+
+    inline void Save(const std::string& filename, const IncrementalIndex& index)
+    {
+        const std::string temporaryFilename = filename + ".tmp";
+        {
+            std::ofstream output(temporaryFilename, std::ios::binary | std::ios::trunc);
+            if (!output.is_open())
+            {
+                throw std::runtime_error("Could not open file " + temporaryFilename + " for writing");
+            }
+
+            output.write(MAGIC, sizeof(MAGIC));
+            Write(output, index.headerHash);
+            Write(output, index.rowHashes);
+            Write(output, index.states);
+            Write(output, index.inputSymbols);
+            Write(output, index.outputSymbols);
+            Write(output, index.nextStates);
+            Write(output, index.outputs);
+            Write(output, index.isReachable);
+            Write(output, index.pairStates);
+            Write(output, index.pairOutputs);
+            Write(output, index.pairCounts);
+            Write(output, index.lineOffsets);
+            Write(output, index.lineHashes);
+
+            if (!output.flush())
+            {
+                throw std::runtime_error("Could not write file " + temporaryFilename);
+            }
+        }
+
+        std::filesystem::rename(temporaryFilename, filename);
+    }
+
+    inline IncrementalIndex Load(const std::string& filename)
+    {
+        std::ifstream input(filename, std::ios::binary);
+        if (!input.is_open())
+        {
+            throw std::runtime_error("no incremental index");
+        }
+
+        char magic[sizeof(MAGIC)] {};
+        input.read(magic, sizeof(magic));
+        if (std::string(magic, sizeof(magic)) != std::string(MAGIC, sizeof(MAGIC)))
+        {
+            throw std::runtime_error("incremental index has unknown format");
+        }
+
+        IncrementalIndex index;
+        Read(input, index.headerHash);
+        Read(input, index.rowHashes);
+        Read(input, index.states);
+        Read(input, index.inputSymbols);
+        Read(input, index.outputSymbols);
+        Read(input, index.nextStates);
+        Read(input, index.outputs);
+        Read(input, index.isReachable);
+        Read(input, index.pairStates);
+        Read(input, index.pairOutputs);
+        Read(input, index.pairCounts);
+        Read(input, index.lineOffsets);
+        Read(input, index.lineHashes);
+
+        const size_t cellCount = index.states.size() * index.rowHashes.size();
+        if (index.inputSymbols.size() != index.rowHashes.size() || index.nextStates.size() != cellCount
+            || index.outputs.size() != cellCount || index.isReachable.size() != index.states.size()
+            || index.pairOutputs.size() != index.pairStates.size() || index.pairCounts.size() != index.pairStates.size()
+            || index.lineOffsets.size() != index.rowHashes.size() + 3
+            || index.lineHashes.size() != index.rowHashes.size() + 2)
+        {
+            throw std::runtime_error("incremental index is inconsistent");
+        }
+
+        return index;
+    }
+}
+
+// Перевод Мили -> Мура, который при повторном запуске на слегка изменённой таблице
+// переразбирает только изменившиеся строки и переписывает только изменившиеся строки
+// автомата Мура. Если нумерация состояний Мура меняется, выполняется полный перевод.
+class IncrementalMealyToMooreConverter
+{
+public:
+    static constexpr auto INDEX_EXTENSION = ".index";
+
+    IncrementalMealyToMooreConverter(std::string inputFilename, std::string outputFilename,
+        const OutputCompression& compression = {})
+        : m_inputFilename(std::move(inputFilename)),
+        m_outputFilename(std::move(outputFilename)),
+        m_indexFilename(m_outputFilename + INDEX_EXTENSION),
+        m_compression(compression)
+    {}
+
+    IncrementalResult Convert() const
+    {
+        const auto format = m_compression.format == CompressionFormat::Auto
+            ? CompressedStream::GetFormatFromExtension(m_outputFilename)
+            : m_compression.format;
+        if (format != CompressionFormat::None)
+        {
+            return ConvertFully("compressed output cannot be patched");
+        }
+
+        IncrementalIndex index;
+        try
+        {
+            index = IncrementalIndexFile::Load(m_indexFilename);
+        }
+        catch (const std::exception& err)
+        {
+            return ConvertFully(err.what());
+        }
+
+        if (!IsOutputUnchanged(index))
+        {
+            return ConvertFully("output file was modified");
+        }
+
+        IncrementalResult result;
+        std::vector<size_t> changedMooreRows;
+        if (const auto reason = UpdateIndex(index, changedMooreRows, result); !reason.empty())
+        {
+            return ConvertFully(reason);
+        }
+
+        RewriteRows(index, changedMooreRows, result);
+        IncrementalIndexFile::Save(m_indexFilename, index);
+
+        return result;
+    }
+
+private:
+    static uint64_t GetHash(const std::string& text)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const unsigned char ch: text)
+        {
+            hash = (hash ^ ch) * 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    static uint64_t GetPairKey(const uint32_t state, const uint32_t output)
+    {
+        return uint64_t(state) << 32 | output;
+    }
+
+    static std::unordered_map<uint64_t, uint32_t> GetPairIndexes(const IncrementalIndex& index)
+    {
+        std::unordered_map<uint64_t, uint32_t> pairIndexes;
+        for (uint32_t pair = 0; pair < index.pairStates.size(); ++pair)
+        {
+            pairIndexes.emplace(GetPairKey(index.pairStates[pair], index.pairOutputs[pair]), pair);
+        }
+
+        return pairIndexes;
+    }
+
+    static std::string GetMooreStateName(const uint32_t pair)
+    {
+        return MealyToMooreConverter::STATE_CHAR + std::to_string(pair);
+    }
+
+    // Строка переходов в том же виде, в каком её пишет MooreAutomata::ExportToCsv
+    static std::string GetMooreRow(const IncrementalIndex& index,
+        const std::unordered_map<uint64_t, uint32_t>& pairIndexes, const size_t input)
+    {
+        const size_t inputCount = index.inputSymbols.size();
+
+        std::string row;
+        MooreAutomata::AppendCsvLine(row, index.inputSymbols[input], index.pairStates.size(), [&](const size_t pair) {
+            const size_t cell = index.pairStates[pair] * inputCount + input;
+            return GetMooreStateName(pairIndexes.at(GetPairKey(index.nextStates[cell], index.outputs[cell])));
+        });
+
+        return row;
+    }
+
+    // Сверяет файл автомата Мура с хешами строк индекса
+    [[nodiscard]] bool IsOutputUnchanged(const IncrementalIndex& index) const
+    {
+        std::error_code error;
+        const auto outputSize = std::filesystem::file_size(m_outputFilename, error);
+        if (error || outputSize != index.lineOffsets.back())
+        {
+            return false;
+        }
+
+        std::ifstream output(m_outputFilename, std::ios::binary);
+        std::string line;
+        for (size_t lineIndex = 0; lineIndex < index.lineHashes.size(); ++lineIndex)
+        {
+            line.resize(index.lineOffsets[lineIndex + 1] - index.lineOffsets[lineIndex]);
+            if (!output.read(line.data(), static_cast<std::streamsize>(line.size()))
+                || GetHash(line) != index.lineHashes[lineIndex])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static std::vector<uint8_t> GetReachableStates(const IncrementalIndex& index)
+    {
+        const size_t inputCount = index.inputSymbols.size();
+
+        std::vector<uint8_t> isReachable(index.states.size(), 0);
+        std::vector<uint32_t> queue { 0 };
+        isReachable[0] = 1;
+        for (size_t position = 0; position < queue.size(); ++position)
+        {
+            const size_t first = queue[position] * inputCount;
+            for (size_t cell = first; cell < first + inputCount; ++cell)
+            {
+                if (!isReachable[index.nextStates[cell]])
+                {
+                    isReachable[index.nextStates[cell]] = 1;
+                    queue.push_back(index.nextStates[cell]);
+                }
+            }
+        }
+
+        return isReachable;
+    }
+
+    // Применяет к индексу изменившиеся строки входного файла. Возвращает причину,
+    // по которой нужен полный перевод, или пустую строку.
+    [[nodiscard]] std::string UpdateIndex(IncrementalIndex& index, std::vector<size_t>& changedMooreRows,
+        IncrementalResult& result) const
+    {
+        CompressedStream::InputFile file(m_inputFilename);
+        if (!file.IsOpen())
+        {
+            throw std::runtime_error("File \"" + m_inputFilename + "\" not found");
+        }
+
+        std::string line;
+        std::getline(file, line);
+        if (GetHash(line) != index.headerHash)
+        {
+            return "states changed";
+        }
+
+        std::unordered_map<std::string, uint32_t> statesIndexes;
+        for (uint32_t state = 0; state < index.states.size(); ++state)
+        {
+            statesIndexes.emplace(index.states[state], state);
+        }
+        std::unordered_map<std::string, uint32_t> outputsIndexes;
+        for (uint32_t output = 0; output < index.outputSymbols.size(); ++output)
+        {
+            outputsIndexes.emplace(index.outputSymbols[output], output);
+        }
+        auto pairIndexes = GetPairIndexes(index);
+        // Пара может исчезнуть в одной строке и снова появиться в следующей,
+        // поэтому обнулившиеся счётчики проверяются после применения всех строк
+        std::vector<uint32_t> decreasedPairs;
+
+        const size_t inputCount = index.inputSymbols.size();
+        bool isNextStateChanged = false;
+        size_t input = 0;
+        for (; std::getline(file, line); ++input)
+        {
+            if (input >= inputCount)
+            {
+                return "number of rows changed";
+            }
+
+            const uint64_t hash = GetHash(line);
+            if (hash == index.rowHashes[input])
+            {
+                continue;
+            }
+            index.rowHashes[input] = hash;
+            ++result.changedRows;
+
+            auto [inputSymbol, transitions] = MealyController::GetTransitionsFromLine(line, index.states);
+            if (transitions.size() != index.states.size())
+            {
+                return "row \"" + inputSymbol + "\" has wrong number of transitions";
+            }
+
+            bool isMooreRowChanged = inputSymbol != index.inputSymbols[input];
+            index.inputSymbols[input] = std::move(inputSymbol);
+
+            for (uint32_t state = 0; state < transitions.size(); ++state)
+            {
+                const auto stateIt = statesIndexes.find(transitions[state].nextState);
+                if (stateIt == statesIndexes.end())
+                {
+                    return "unknown state \"" + transitions[state].nextState + "\"";
+                }
+                const auto [outputIt, isNewOutput] = outputsIndexes.try_emplace(
+                    transitions[state].outputSymbol, static_cast<uint32_t>(index.outputSymbols.size()));
+                if (isNewOutput)
+                {
+                    index.outputSymbols.push_back(transitions[state].outputSymbol);
+                }
+
+                const size_t cell = state * inputCount + input;
+                const uint32_t oldNextState = index.nextStates[cell];
+                const uint32_t oldOutput = index.outputs[cell];
+                if (oldNextState == stateIt->second && oldOutput == outputIt->second)
+                {
+                    continue;
+                }
+
+                index.nextStates[cell] = stateIt->second;
+                index.outputs[cell] = outputIt->second;
+                if (!index.isReachable[state])
+                {
+                    continue;
+                }
+
+                isMooreRowChanged = true;
+                isNextStateChanged = isNextStateChanged || oldNextState != stateIt->second;
+
+                const auto newPair = pairIndexes.find(GetPairKey(stateIt->second, outputIt->second));
+                if (newPair == pairIndexes.end())
+                {
+                    return "new Moore state appeared";
+                }
+                ++index.pairCounts[newPair->second];
+                const auto oldPair = pairIndexes.at(GetPairKey(oldNextState, oldOutput));
+                --index.pairCounts[oldPair];
+                decreasedPairs.push_back(oldPair);
+            }
+
+            if (isMooreRowChanged)
+            {
+                changedMooreRows.push_back(input);
+            }
+        }
+
+        if (input != inputCount)
+        {
+            return "number of rows changed";
+        }
+
+        for (const auto pair: decreasedPairs)
+        {
+            if (index.pairCounts[pair] == 0)
+            {
+                return "Moore state disappeared";
+            }
+        }
+
+        // Удаление перехода может сделать состояния недостижимыми, поэтому множество
+        // достижимых состояний перепроверяется по таблице индекса
+        if (isNextStateChanged && GetReachableStates(index) != index.isReachable)
+        {
+            return "reachable states changed";
+        }
+
+        return {};
+    }
+
+    // Переписывает изменившиеся строки автомата Мура: на месте, если длина строк не изменилась,
+    // иначе копированием неизменных частей файла
+    void RewriteRows(IncrementalIndex& index, const std::vector<size_t>& changedMooreRows,
+        IncrementalResult& result) const
+    {
+        const auto pairIndexes = GetPairIndexes(index);
+        constexpr size_t HEADER_LINES = 2;
+
+        std::vector<std::string> rows;
+        for (const auto input: changedMooreRows)
+        {
+            rows.emplace_back(GetMooreRow(index, pairIndexes, input));
+            const size_t line = HEADER_LINES + input;
+            index.lineHashes[line] = GetHash(rows.back());
+            if (rows.back().size() != index.lineOffsets[line + 1] - index.lineOffsets[line])
+            {
+                result.isRewrittenInPlace = false;
+            }
+        }
+        result.rewrittenRows = rows.size();
+        if (rows.empty())
+        {
+            return;
+        }
+
+        if (result.isRewrittenInPlace)
+        {
+            std::fstream output(m_outputFilename, std::ios::in | std::ios::out | std::ios::binary);
+            for (size_t row = 0; row < rows.size(); ++row)
+            {
+                output.seekp(static_cast<std::streamoff>(index.lineOffsets[HEADER_LINES + changedMooreRows[row]]));
+                output.write(rows[row].data(), static_cast<std::streamsize>(rows[row].size()));
+            }
+            if (!output.flush())
+            {
+                throw std::runtime_error("Could not write file " + m_outputFilename);
+            }
+
+            return;
+        }
+
+        const std::string temporaryFilename = m_outputFilename + ".tmp";
+        {
+            std::ifstream oldOutput(m_outputFilename, std::ios::binary);
+            std::ofstream newOutput(temporaryFilename, std::ios::binary | std::ios::trunc);
+            if (!oldOutput.is_open() || !newOutput.is_open())
+            {
+                throw std::runtime_error("Could not rewrite file " + m_outputFilename);
+            }
+
+            std::vector<uint64_t> lineOffsets { 0 };
+            std::string buffer;
+            auto copyLines = [&](const size_t firstLine, const size_t lastLine) {
+                buffer.resize(index.lineOffsets[lastLine] - index.lineOffsets[firstLine]);
+                oldOutput.seekg(static_cast<std::streamoff>(index.lineOffsets[firstLine]));
+                oldOutput.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                newOutput.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                for (size_t line = firstLine; line < lastLine; ++line)
+                {
+                    lineOffsets.push_back(lineOffsets.back() + index.lineOffsets[line + 1] - index.lineOffsets[line]);
+                }
+            };
+
+            size_t nextLine = 0;
+            for (size_t row = 0; row < rows.size(); ++row)
+            {
+                const size_t line = HEADER_LINES + changedMooreRows[row];
+                copyLines(nextLine, line);
+                newOutput.write(rows[row].data(), static_cast<std::streamsize>(rows[row].size()));
+                lineOffsets.push_back(lineOffsets.back() + rows[row].size());
+                nextLine = line + 1;
+            }
+            copyLines(nextLine, index.lineOffsets.size() - 1);
+
+            if (!oldOutput || !newOutput.flush())
+            {
+                throw std::runtime_error("Could not rewrite file " + m_outputFilename);
+            }
+            index.lineOffsets = std::move(lineOffsets);
+        }
+
+        std::filesystem::rename(temporaryFilename, m_outputFilename);
+    }
+
+    [[nodiscard]] IncrementalResult ConvertFully(const std::string& reason) const
+    {
+        IncrementalIndex index = ReadIndexedMealy();
+
+        const size_t stateCount = index.states.size();
+        const size_t inputCount = index.inputSymbols.size();
+        auto states = index.states;
+        auto inputSymbols = index.inputSymbols;
+        auto outputSymbols = index.outputSymbols;
+        auto nextStates = index.nextStates;
+        auto outputs = index.outputs;
+        const IndexedMealyAutomata<uint32_t> mealy(std::move(states), std::move(inputSymbols),
+            std::move(outputSymbols), std::move(nextStates), std::move(outputs));
+        const IndexedConversion::MealyToMooreKernel<uint32_t> kernel(mealy);
+
+        index.isReachable.resize(stateCount);
+        for (size_t state = 0; state < stateCount; ++state)
+        {
+            index.isReachable[state] = kernel.IsReachable(state);
+        }
+
+        for (size_t pair = 0; pair < kernel.GetMooreStateCount(); ++pair)
+        {
+            index.pairStates.push_back(kernel.GetMooreStateOrigin(pair));
+            index.pairOutputs.push_back(kernel.GetMooreStateOutput(pair).value_or(IncrementalIndex::EMPTY_OUTPUT));
+        }
+        index.pairCounts.assign(index.pairStates.size(), 0);
+
+        const auto pairIndexes = GetPairIndexes(index);
+        for (size_t state = 0; state < stateCount; ++state)
+        {
+            if (!index.isReachable[state])
+            {
+                continue;
+            }
+            for (size_t cell = state * inputCount; cell < (state + 1) * inputCount; ++cell)
+            {
+                ++index.pairCounts[pairIndexes.at(GetPairKey(index.nextStates[cell], index.outputs[cell]))];
+            }
+        }
+
+        WriteMooreAutomata(index, pairIndexes);
+
+        IncrementalResult result;
+        result.isFullConversion = true;
+        result.fullConversionReason = reason;
+        result.rewrittenRows = inputCount;
+        return result;
+    }
+
+    // Читает весь входной файл в индекс: хеши строк и таблицу Мили в индексах
+    [[nodiscard]] IncrementalIndex ReadIndexedMealy() const
+    {
+        CompressedStream::InputFile input(m_inputFilename);
+        if (!input.IsOpen())
+        {
+            throw std::runtime_error("File \"" + m_inputFilename + "\" not found");
+        }
+
+        IncrementalIndex index;
+        std::string line;
+        std::getline(input, line);
+        index.headerHash = GetHash(line);
+        std::istringstream header(line);
+        index.states = MealyController::GetStatesFromFile(header);
+
+        SymbolTable states;
+        for (const auto& state: index.states)
+        {
+            IndexedController::InternState(states, state);
+        }
+        SymbolTable outputSymbols;
+
+        std::vector<uint32_t> rowNextStates;
+        std::vector<uint32_t> rowOutputs;
+        while (std::getline(input, line))
+        {
+            index.rowHashes.push_back(GetHash(line));
+
+            auto [inputSymbol, transitions] = MealyController::GetTransitionsFromLine(line, index.states);
+            if (transitions.size() != index.states.size())
+            {
+                throw std::invalid_argument("Row \"" + inputSymbol + "\" has " + std::to_string(transitions.size())
+                    + " transitions, expected " + std::to_string(index.states.size()));
+            }
+
+            for (const auto& transition: transitions)
+            {
+                rowNextStates.push_back(IndexedController::GetStateIndex(states, transition.nextState));
+                rowOutputs.push_back(outputSymbols.Intern(transition.outputSymbol));
+            }
+            index.inputSymbols.emplace_back(std::move(inputSymbol));
+        }
+        index.outputSymbols = outputSymbols.ReleaseNames();
+
+        // Строки файла переставляются в хранение по столбцам
+        const size_t stateCount = index.states.size();
+        const size_t inputCount = index.inputSymbols.size();
+        index.nextStates.resize(stateCount * inputCount);
+        index.outputs.resize(stateCount * inputCount);
+        for (size_t input = 0; input < inputCount; ++input)
+        {
+            for (size_t state = 0; state < stateCount; ++state)
+            {
+                index.nextStates[state * inputCount + input] = rowNextStates[input * stateCount + state];
+                index.outputs[state * inputCount + input] = rowOutputs[input * stateCount + state];
+            }
+        }
+
+        return index;
+    }
+
+    // Файл открывается так же, как при обычной записи автомата Мура, поэтому перевод
+    // с --incremental и без него даёт одинаковые файлы
+    void WriteMooreAutomata(IncrementalIndex& index, const std::unordered_map<uint64_t, uint32_t>& pairIndexes) const
+    {
+        CompressedStream::OutputFile output(m_outputFilename, m_compression);
+        if (!output.IsOpen())
+        {
+            throw std::runtime_error("Could not open the file for writing.");
+        }
+
+        index.lineOffsets = { 0 };
+        index.lineHashes.clear();
+        auto writeLine = [&](const std::string& text) {
+            output << text;
+            index.lineOffsets.push_back(index.lineOffsets.back() + text.size());
+            index.lineHashes.push_back(GetHash(text));
+        };
+
+        const size_t pairCount = index.pairStates.size();
+        std::string line;
+        MooreAutomata::AppendCsvLine(line, "", pairCount, [&](const size_t pair) {
+            return index.pairOutputs[pair] == IncrementalIndex::EMPTY_OUTPUT
+                ? std::string()
+                : index.outputSymbols[index.pairOutputs[pair]];
+        });
+        writeLine(line);
+        line.clear();
+        MooreAutomata::AppendCsvLine(line, "", pairCount, [](const size_t pair) {
+            return GetMooreStateName(static_cast<uint32_t>(pair));
+        });
+        writeLine(line);
+        for (size_t input = 0; input < index.inputSymbols.size(); ++input)
+        {
+            writeLine(GetMooreRow(index, pairIndexes, input));
+        }
+        output.Close();
+
+        // Сжатый файл нельзя исправлять по строкам, поэтому индекс для него не сохраняется
+        const bool isCompressed = (m_compression.format == CompressionFormat::Auto
+            ? CompressedStream::GetFormatFromExtension(m_outputFilename)
+            : m_compression.format) != CompressionFormat::None;
+        if (!isCompressed)
+        {
+            IncrementalIndexFile::Save(m_indexFilename, index);
+        }
+    }
+
+    std::string m_inputFilename;
+    std::string m_outputFilename;
+    std::string m_indexFilename;
+    OutputCompression m_compression;
+};
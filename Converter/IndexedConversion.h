@@ -0,0 +1,264 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../Automata/IndexedAutomata.h"
+
+namespace IndexedConversion
+{
+    // Ядро перевода Мили -> Мура на индексах. Повторяет нумерацию MealyToMooreConverter:
+    // состояния Мура упорядочены по состоянию Мили, затем по выходному символу
+    // в лексикографическом порядке; для достижимых состояний без входящих переходов
+    // добавляется пара (состояние, "").
+    template <typename Index>
+    class MealyToMooreKernel
+    {
+    public:
+        explicit MealyToMooreKernel(const IndexedMealyAutomata<Index>& mealy)
+            : m_mealy(mealy),
+            m_emptyOutput(static_cast<uint32_t>(mealy.GetOutputSymbols().size()))
+        {
+            if (mealy.GetStateCount() == 0)
+            {
+                throw std::invalid_argument("Mealy automata has no states");
+            }
+
+            CollectReachableStates();
+            CollectPairs();
+        }
+
+        // Количество индексов, которое должно поместиться в тип индекса автомата Мура
+        [[nodiscard]] size_t GetRequiredIndexCount() const
+        {
+            return std::max(m_pairs.size(), size_t(m_emptyOutput) + 1);
+        }
+
+        [[nodiscard]] bool IsReachable(const size_t state) const
+        {
+            return m_isReachable[state];
+        }
+
+        [[nodiscard]] size_t GetMooreStateCount() const
+        {
+            return m_pairs.size();
+        }
+
+        // Состояние Мили, из которого получено состояние Мура с номером index
+        [[nodiscard]] uint32_t GetMooreStateOrigin(const size_t index) const
+        {
+            return static_cast<uint32_t>(m_pairs[index] / (size_t(m_emptyOutput) + 1));
+        }
+
+        // Выходной символ состояния Мура; std::nullopt для пары (состояние, "")
+        [[nodiscard]] std::optional<uint32_t> GetMooreStateOutput(const size_t index) const
+        {
+            const auto rank = static_cast<uint32_t>(m_pairs[index] % (size_t(m_emptyOutput) + 1));
+            if (rank == m_emptyOutput)
+            {
+                return std::nullopt;
+            }
+
+            return m_outputsByName[rank];
+        }
+
+        template <typename MooreIndex>
+        [[nodiscard]] IndexedMooreAutomata<MooreIndex> Build(const char stateChar) const
+        {
+            const size_t inputCount = m_mealy.GetInputCount();
+            const size_t outputCount = size_t(m_emptyOutput) + 1;
+
+            std::vector<std::string> states;
+            std::vector<MooreIndex> stateOutputs;
+            states.reserve(m_pairs.size());
+            stateOutputs.reserve(m_pairs.size());
+            for (size_t index = 0; index < m_pairs.size(); ++index)
+            {
+                states.emplace_back(stateChar + std::to_string(index));
+                const auto rank = static_cast<uint32_t>(m_pairs[index] % outputCount);
+                stateOutputs.push_back(static_cast<MooreIndex>(rank == m_emptyOutput ? rank : m_outputsByName[rank]));
+            }
+
+            std::vector<MooreIndex> nextStates(m_pairs.size() * inputCount);
+            std::vector<MooreIndex> column(inputCount);
+            for (size_t pair = 0; pair < m_pairs.size();)
+            {
+                const auto state = static_cast<uint32_t>(m_pairs[pair] / outputCount);
+                const auto mealyNextStates = m_mealy.GetNextStates(state);
+                const auto mealyOutputs = m_mealy.GetOutputs(state);
+                for (size_t input = 0; input < inputCount; ++input)
+                {
+                    column[input] = static_cast<MooreIndex>(GetPairIndex(mealyNextStates[input], mealyOutputs[input]));
+                }
+
+                for (; pair < m_pairs.size() && m_pairs[pair] / outputCount == state; ++pair)
+                {
+                    std::copy(column.begin(), column.end(), nextStates.begin() + pair * inputCount);
+                }
+            }
+
+            auto inputSymbols = m_mealy.GetInputSymbols();
+            auto outputSymbols = m_mealy.GetOutputSymbols();
+            outputSymbols.emplace_back("");
+
+            return {
+                std::move(states),
+                std::move(inputSymbols),
+                std::move(outputSymbols),
+                std::move(stateOutputs),
+                std::move(nextStates)
+            };
+        }
+
+    private:
+        void CollectReachableStates()
+        {
+            m_isReachable.assign(m_mealy.GetStateCount(), false);
+            m_isReachable[0] = true;
+
+            std::vector<uint32_t> queue { 0 };
+            for (size_t index = 0; index < queue.size(); ++index)
+            {
+                for (const auto nextState: m_mealy.GetNextStates(queue[index]))
+                {
+                    if (!m_isReachable[nextState])
+                    {
+                        m_isReachable[nextState] = true;
+                        queue.push_back(nextState);
+                    }
+                }
+            }
+        }
+
+        // Пара (состояние, выход) кодируется как state * outputCount + ранг выхода
+        // (пустому выходу соответствует ранг m_emptyOutput); пары упорядочены так же,
+        // как нумеруются состояния Мура
+        void CollectPairs()
+        {
+            const auto& outputSymbols = m_mealy.GetOutputSymbols();
+            const size_t outputCount = size_t(m_emptyOutput) + 1;
+
+            m_outputsByName.resize(outputSymbols.size());
+            std::iota(m_outputsByName.begin(), m_outputsByName.end(), 0);
+            std::sort(m_outputsByName.begin(), m_outputsByName.end(), [&](const uint32_t a, const uint32_t b) {
+                return outputSymbols[a] < outputSymbols[b];
+            });
+            m_outputRanks.resize(outputSymbols.size());
+            for (uint32_t rank = 0; rank < m_outputsByName.size(); ++rank)
+            {
+                m_outputRanks[m_outputsByName[rank]] = rank;
+            }
+
+            // Ранги выходов раскладываются по корзинам целевых состояний,
+            // после чего каждая небольшая корзина сортируется отдельно
+            const size_t stateCount = m_mealy.GetStateCount();
+            std::vector<size_t> bucketStarts(stateCount + 1, 0);
+            ForEachReachableCell([&](const uint32_t nextState, uint32_t) {
+                ++bucketStarts[nextState + 1];
+            });
+            std::partial_sum(bucketStarts.begin(), bucketStarts.end(), bucketStarts.begin());
+
+            std::vector<uint32_t> buckets(bucketStarts.back());
+            std::vector<size_t> bucketEnds(bucketStarts.begin(), bucketStarts.end() - 1);
+            ForEachReachableCell([&](const uint32_t nextState, const uint32_t output) {
+                buckets[bucketEnds[nextState]++] = m_outputRanks[output];
+            });
+
+            m_pairStarts.assign(stateCount + 1, 0);
+            for (uint32_t state = 0; state < stateCount; ++state)
+            {
+                const auto first = buckets.begin() + bucketStarts[state];
+                const auto last = buckets.begin() + bucketStarts[state + 1];
+                std::sort(first, last);
+                const auto uniqueLast = std::unique(first, last);
+
+                if (first == last && m_isReachable[state])
+                {
+                    m_pairs.push_back(uint64_t(state) * outputCount + m_emptyOutput);
+                }
+                for (auto it = first; it != uniqueLast; ++it)
+                {
+                    m_pairs.push_back(uint64_t(state) * outputCount + *it);
+                }
+
+                m_pairStarts[state + 1] = m_pairs.size();
+            }
+        }
+
+        template <typename Callback>
+        void ForEachReachableCell(Callback&& callback) const
+        {
+            for (uint32_t state = 0; state < m_mealy.GetStateCount(); ++state)
+            {
+                if (!m_isReachable[state])
+                {
+                    continue;
+                }
+
+                const auto nextStates = m_mealy.GetNextStates(state);
+                const auto outputs = m_mealy.GetOutputs(state);
+                for (size_t input = 0; input < nextStates.size(); ++input)
+                {
+                    callback(nextStates[input], outputs[input]);
+                }
+            }
+        }
+
+        [[nodiscard]] size_t GetPairIndex(const uint32_t nextState, const uint32_t output) const
+        {
+            const size_t outputCount = size_t(m_emptyOutput) + 1;
+            const auto first = m_pairs.begin() + m_pairStarts[nextState];
+            const auto last = m_pairs.begin() + m_pairStarts[nextState + 1];
+            const uint32_t rank = m_outputRanks[output];
+
+            const auto it = std::lower_bound(first, last, rank, [&](const uint64_t pair, const uint32_t value) {
+                return pair % outputCount < value;
+            });
+
+            return it - m_pairs.begin();
+        }
+
+        const IndexedMealyAutomata<Index>& m_mealy;
+        uint32_t m_emptyOutput;
+        std::vector<bool> m_isReachable;
+        std::vector<uint32_t> m_outputRanks;
+        std::vector<uint32_t> m_outputsByName;
+        // Пары (состояние, ранг выхода) в порядке нумерации состояний Мура
+        std::vector<uint64_t> m_pairs;
+        std::vector<size_t> m_pairStarts;
+    };
+
+    template <typename Index>
+    IndexedMealyAutomata<Index> ConvertMooreToMealy(const IndexedMooreAutomata<Index>& moore, const char stateChar)
+    {
+        std::vector<std::string> states = moore.GetStates();
+        for (auto& state: states)
+        {
+            if (!state.empty())
+            {
+                state[0] = stateChar;
+            }
+        }
+
+        const auto& stateOutputs = moore.GetStateOutputs();
+        std::vector<Index> nextStates = moore.GetNextStates();
+        std::vector<Index> outputs(nextStates.size());
+        std::transform(nextStates.begin(), nextStates.end(), outputs.begin(), [&](const Index state) {
+            return stateOutputs[state];
+        });
+
+        auto inputSymbols = moore.GetInputSymbols();
+        auto outputSymbols = moore.GetOutputSymbols();
+
+        return {
+            std::move(states),
+            std::move(inputSymbols),
+            std::move(outputSymbols),
+            std::move(nextStates),
+            std::move(outputs)
+        };
+    }
+}
@@ -3,215 +3,469 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <unordered_map>
 
+#include "IndexedConversion.h"
 #include "../Automata/MealyAutomata.h"
 #include "../Automata/MooreAutomata.h"
 
+enum class MooreConstruction
+{
+    // Состояния Мура создаются для всех пар (состояние, выход) из очищенной таблицы Мили
+    Full,
+    // Состояния Мура создаются по мере обхода в ширину от стартового состояния
+    Reachable
+};
+
 class MealyToMooreConverter
 {
 public:
     static constexpr char STATE_CHAR = 'q';
     static constexpr size_t FIRST_STATE_INDEX = 0;
 
-    explicit MealyToMooreConverter(std::unique_ptr<MealyAutomata> mealy)
-        : m_mealy(std::move(mealy))
+    explicit MealyToMooreConverter(std::unique_ptr<MealyAutomata> mealy,
+        const MooreConstruction construction = MooreConstruction::Full)
+        : m_mealy(std::move(mealy)),
+        m_construction(construction)
     {}
 
     [[nodiscard]] std::unique_ptr<MooreAutomata> GetMooreAutomata() const
     {
-        auto mealyTransitionTable = m_mealy->GetTransitionTable();
-        auto mealyStates = m_mealy->GetStates();
-        auto inputSymbols = m_mealy->GetInputSymbols();
-
-        ClearImpossibleStates(mealyTransitionTable, mealyStates);
-
-        auto uniqueTransitions = GetUniqueTransitions(mealyTransitionTable, mealyStates);
-
-        auto stateToTransitions = GetStateToTransitionsMap(uniqueTransitions);
-
-        auto transitionToNewStateName = GetNewStateNamesFromTransitions(uniqueTransitions, mealyStates, stateToTransitions);
-
-        auto mooreStatesInfo = GetMooreStatesInfo(transitionToNewStateName);
-
-        MooreTransitionTable mooreTransitionTable;
-        for (auto& row: mealyTransitionTable)
+        if (m_construction == MooreConstruction::Reachable)
         {
-            std::string inputSymbol = row.first;
-            std::vector<State> states;
-            for (unsigned index = 0; auto& it: row.second)
-            {
-                const std::string& state = mealyStates[index++];
-                std::string newState = transitionToNewStateName[it];
-
-                auto transitionsCount = GetTransitionsCountWithEqualState(state, stateToTransitions);
+            return GetReachableMooreAutomata();
+        }
 
-                states.insert(states.end(), transitionsCount, newState);
-            }
-            mooreTransitionTable.emplace_back(inputSymbol, states);
+        if (m_mealy->IsSparse())
+        {
+            return GetSparseMooreAutomata();
         }
 
-        return std::make_unique<MooreAutomata>(
-            std::move(inputSymbols),
-            std::move(mooreStatesInfo),
-            std::move(mooreTransitionTable));
+        return GetIndexedMooreAutomata();
     }
 
 private:
-    static unsigned GetTransitionsCountWithEqualState(const std::string& state,
-        std::map<State, std::set<Transition>>& stateToTransitions)
+    // Ядро работает с индексами той ширины, в которой загружен автомат Мили;
+    // ширина индексов автомата Мура выбирается отдельно, когда известно число его состояний
+    [[nodiscard]] std::unique_ptr<MooreAutomata> GetIndexedMooreAutomata() const
     {
-        return stateToTransitions[state].size();
+        return std::visit([&]<typename Index>(const IndexedMealyAutomata<Index>& mealy) {
+            const IndexedConversion::MealyToMooreKernel<Index> kernel(mealy);
+
+            const auto mooreWidth = SelectIndexWidth(kernel.GetRequiredIndexCount());
+            return DispatchIndexWidth(mooreWidth, [&]<typename MooreIndex>(std::type_identity<MooreIndex>) {
+                return std::make_unique<MooreAutomata>(kernel.template Build<MooreIndex>(STATE_CHAR));
+            });
+        }, m_mealy->GetIndexedAutomata());
     }
 
-    static MooreStatesInfo GetMooreStatesInfo(std::map<Transition, std::string>& transitionToNewStateName)
+    // Обход в ширину по индексированной таблице; ячейки столбца перебираются по входным
+    // символам, поэтому нумерация состояний Мура совпадает с разреженным обходом
+    template <typename Index>
+    [[nodiscard]] static std::unique_ptr<MooreAutomata> GetReachableIndexedMooreAutomata(
+        const IndexedMealyAutomata<Index>& mealy)
     {
-        MooreStatesInfo mooreStateInfo;
-        for (auto& it: transitionToNewStateName)
+        const size_t stateCount = mealy.GetStateCount();
+        const size_t inputCount = mealy.GetInputCount();
+        if (stateCount == 0)
         {
-            mooreStateInfo.emplace_back(it.second, it.first.outputSymbol);
+            throw std::invalid_argument("Mealy automata has no states");
         }
 
-        std::sort(mooreStateInfo.begin(), mooreStateInfo.end(), SortStringFromIndexesComp);
+        // Пара (состояние, выход) кодируется как state * outputCount + output,
+        // последний номер выхода соответствует пустому выходу
+        const uint32_t emptyOutput = static_cast<uint32_t>(mealy.GetOutputSymbols().size());
+        const uint64_t outputCount = uint64_t(emptyOutput) + 1;
 
-        return mooreStateInfo;
-    }
+        std::unordered_map<uint64_t, uint32_t> pairToId;
+        std::vector<uint64_t> pairs;
+        std::vector<int64_t> columnIndexes(stateCount, -1);
+        std::vector<uint32_t> reachedStates { 0 };
+        std::vector<uint32_t> columns;
+        columnIndexes[0] = 0;
 
-    static std::map<State, std::set<Transition>> GetStateToTransitionsMap(std::vector<Transition>& transitions)
-    {
-        std::map<State, std::set<Transition>> stateToTransitions;
-        for (auto& transition: transitions)
+        for (size_t reachedIndex = 0; reachedIndex < reachedStates.size(); ++reachedIndex)
         {
-            if (!stateToTransitions.contains(transition.nextState))
+            const auto nextStates = mealy.GetNextStates(reachedStates[reachedIndex]);
+            const auto outputs = mealy.GetOutputs(reachedStates[reachedIndex]);
+            for (size_t input = 0; input < inputCount; ++input)
             {
-                stateToTransitions[transition.nextState] = {};
+                const uint32_t nextState = nextStates[input];
+                auto [it, inserted] = pairToId.try_emplace(nextState * outputCount + outputs[input],
+                    static_cast<uint32_t>(pairs.size()));
+                if (inserted)
+                {
+                    pairs.push_back(it->first);
+                    if (columnIndexes[nextState] < 0)
+                    {
+                        columnIndexes[nextState] = static_cast<int64_t>(reachedStates.size());
+                        reachedStates.push_back(nextState);
+                    }
+                }
+                columns.push_back(it->second);
             }
+        }
 
-            if (!stateToTransitions[transition.nextState].contains(transition))
+        std::vector<uint32_t> mooreOrder;
+        mooreOrder.reserve(pairs.size() + 1);
+        const auto startIt = std::find_if(pairs.begin(), pairs.end(), [&](const uint64_t pair) {
+            return pair / outputCount == 0;
+        });
+        if (startIt == pairs.end())
+        {
+            pairs.push_back(emptyOutput);
+            mooreOrder.push_back(static_cast<uint32_t>(pairs.size() - 1));
+        }
+        else
+        {
+            mooreOrder.push_back(static_cast<uint32_t>(startIt - pairs.begin()));
+        }
+        for (uint32_t id = 0; id < pairs.size(); ++id)
+        {
+            if (id != mooreOrder.front())
             {
-                stateToTransitions[transition.nextState].emplace(transition);
+                mooreOrder.push_back(id);
             }
         }
 
-        return stateToTransitions;
-    }
+        std::vector<uint32_t> newIndexes(pairs.size());
+        for (uint32_t index = 0; index < mooreOrder.size(); ++index)
+        {
+            newIndexes[mooreOrder[index]] = index;
+        }
 
-    static std::map<Transition, std::string> GetNewStateNamesFromTransitions(std::vector<Transition>& transitions,
-        MealyStates& states, std::map<State, std::set<Transition>>& stateToTransitions)
-    {
-        std::map<Transition, std::string> transitionToNewStateNames;
-        for (unsigned index = FIRST_STATE_INDEX; auto& state: states)
+        std::vector<std::string> states;
+        std::vector<uint32_t> stateOutputs;
+        std::vector<uint32_t> mooreNextStates;
+        states.reserve(mooreOrder.size());
+        stateOutputs.reserve(mooreOrder.size());
+        mooreNextStates.reserve(mooreOrder.size() * inputCount);
+        for (uint32_t index = FIRST_STATE_INDEX; const auto id: mooreOrder)
         {
-            for (auto& transition: stateToTransitions[state])
+            states.emplace_back(STATE_CHAR + std::to_string(index++));
+            stateOutputs.push_back(static_cast<uint32_t>(pairs[id] % outputCount));
+
+            const size_t column = columnIndexes[pairs[id] / outputCount] * inputCount;
+            for (size_t input = 0; input < inputCount; ++input)
             {
-                transitionToNewStateNames[transition] = STATE_CHAR + std::to_string(index++);
+                mooreNextStates.push_back(newIndexes[columns[column + input]]);
             }
         }
 
-        return transitionToNewStateNames;
+        auto inputSymbols = mealy.GetInputSymbols();
+        auto outputSymbols = mealy.GetOutputSymbols();
+        outputSymbols.emplace_back("");
+
+        const size_t idCount = std::max(states.size(), outputSymbols.size());
+        IndexedMooreAutomata<uint32_t> moore(
+            std::move(states),
+            std::move(inputSymbols),
+            std::move(outputSymbols),
+            std::move(stateOutputs),
+            std::move(mooreNextStates));
+
+        return std::make_unique<MooreAutomata>(NarrowToIndexWidth(std::move(moore), idCount));
     }
 
-    static std::vector<Transition> GetUniqueTransitions(MealyTransitionTable& transitionTable, MealyStates& states)
+    using MooreStatePair = std::pair<unsigned, std::string>;
+
+    // Строит автомат Мура обходом в ширину от стартового состояния. Столбец каждого
+    // достижимого состояния Мили читается один раз: все состояния Мура, порождённые
+    // одним состоянием Мили, имеют одинаковые переходы. Стартовым становится первое
+    // найденное состояние Мура для стартового состояния Мили, а если в него нет входящих
+    // переходов, то пара (состояние, "").
+    [[nodiscard]] std::unique_ptr<MooreAutomata> GetReachableMooreAutomata() const
     {
-        std::set<State> statesInTransitions;
-        std::set<Transition> uniqueTransitions;
-        std::vector<Transition> uniqueTransitionVector;
+        if (!m_mealy->IsSparse())
+        {
+            return std::visit([](const auto& mealy) {
+                return GetReachableIndexedMooreAutomata(mealy);
+            }, m_mealy->GetIndexedAutomata());
+        }
+
+        const auto mealyStates = m_mealy->GetStates();
+        if (mealyStates.empty())
+        {
+            throw std::invalid_argument("Mealy automata has no states");
+        }
+
+        const auto& table = m_mealy->GetSparseTransitionTable();
+        const size_t inputCount = table.GetInputCount();
+
+        std::unordered_map<std::string, unsigned> statesIndexes;
+        for (unsigned index = 0; auto& state: mealyStates)
+        {
+            statesIndexes.emplace(state, index++);
+        }
+
+        std::map<MooreStatePair, unsigned> pairToId;
+        std::vector<MooreStatePair> pairs;
+        std::vector<int> columnIndexes(mealyStates.size(), -1);
+        std::vector<unsigned> reachedStates { 0 };
+        std::vector<std::vector<unsigned>> columns;
+        columnIndexes[0] = 0;
+
+        auto getPairId = [&](const Transition& transition) {
+            const auto stateIt = statesIndexes.find(transition.nextState);
+            if (stateIt == statesIndexes.end())
+            {
+                throw std::invalid_argument("Unknown state \"" + transition.nextState + "\" in transition table");
+            }
+
+            const unsigned nextState = stateIt->second;
+            auto [it, inserted] = pairToId.try_emplace({ nextState, transition.outputSymbol }, pairs.size());
+            if (inserted)
+            {
+                pairs.push_back(it->first);
+                if (columnIndexes[nextState] < 0)
+                {
+                    columnIndexes[nextState] = static_cast<int>(reachedStates.size());
+                    reachedStates.push_back(nextState);
+                }
+            }
+
+            return it->second;
+        };
 
-        for (auto& row: transitionTable)
+        // Столбец хранится как значение по умолчанию и исключения, но номера парам выдаются
+        // в порядке первого появления по входным символам, как при обходе плотной таблицы
+        const size_t first = table.HasDefaults() ? 1 : 0;
+        for (size_t reachedIndex = 0; reachedIndex < reachedStates.size(); ++reachedIndex)
         {
-            for (auto& transition: row.second)
+            const unsigned state = reachedStates[reachedIndex];
+            const auto cells = table.GetExceptionCells(state);
+            const size_t defaultPosition = first != 0 ? table.GetFirstDefaultInput(state) : cells.size();
+
+            std::vector<unsigned> column(cells.size() + first);
+            for (size_t exception = 0; exception < cells.size(); ++exception)
             {
-                if (!uniqueTransitions.contains(transition))
+                if (first != 0 && exception == defaultPosition)
                 {
-                    uniqueTransitions.emplace(transition);
-                    uniqueTransitionVector.emplace_back(transition);
-                    statesInTransitions.emplace(transition.nextState);
+                    column.front() = getPairId(table.GetDefault(state));
                 }
+                column[exception + first] = getPairId(cells[exception]);
+            }
+            if (first != 0 && defaultPosition >= cells.size())
+            {
+                column.front() = getPairId(table.GetDefault(state));
             }
+
+            columns.emplace_back(std::move(column));
         }
 
-        for (auto& it: states)
+        std::vector<unsigned> mooreOrder;
+        mooreOrder.reserve(pairs.size() + 1);
+        const auto startIt = std::find_if(pairs.begin(), pairs.end(), [](const MooreStatePair& pair) {
+            return pair.first == 0;
+        });
+        if (startIt == pairs.end())
+        {
+            pairs.emplace_back(0, "");
+            mooreOrder.push_back(pairs.size() - 1);
+        }
+        else
+        {
+            mooreOrder.push_back(startIt - pairs.begin());
+        }
+        for (unsigned id = 0; id < pairs.size(); ++id)
         {
-            if (!statesInTransitions.contains(it))
+            if (id != mooreOrder.front())
             {
-                uniqueTransitionVector.emplace_back(it, "");
-                uniqueTransitions.emplace(it, "");
+                mooreOrder.push_back(id);
             }
         }
 
-        return uniqueTransitionVector;
-    }
+        std::vector<std::string> pairNames(pairs.size());
+        MooreStatesInfo mooreStatesInfo;
+        for (unsigned index = FIRST_STATE_INDEX; auto id: mooreOrder)
+        {
+            pairNames[id] = STATE_CHAR + std::to_string(index++);
+            mooreStatesInfo.emplace_back(pairNames[id], pairs[id].second);
+        }
 
-    static bool SortStringFromIndexesComp(const std::pair<std::string, std::string>& a, const std::pair<std::string, std::string>& b)
-    {
-        int numA = std::stoi(a.first.substr(1));
-        int numB = std::stoi(b.first.substr(1));
+        auto inputSymbols = m_mealy->GetInputSymbols();
 
-        return numA < numB;
+        std::vector<State> defaults;
+        std::vector<size_t> offsets { 0 };
+        std::vector<unsigned> exceptionInputs;
+        std::vector<State> exceptionCells;
+        for (auto id: mooreOrder)
+        {
+            const unsigned state = pairs[id].first;
+            const auto& column = columns[columnIndexes[state]];
+            const auto inputs = table.GetExceptionInputs(state);
+
+            if (first != 0)
+            {
+                defaults.emplace_back(pairNames[column.front()]);
+            }
+            for (size_t exception = 0; exception < inputs.size(); ++exception)
+            {
+                exceptionInputs.push_back(inputs[exception]);
+                exceptionCells.emplace_back(pairNames[column[exception + first]]);
+            }
+            offsets.push_back(exceptionInputs.size());
+        }
+
+        SparseMooreTransitionTable mooreTransitionTable(
+            inputCount,
+            std::move(defaults),
+            std::move(offsets),
+            std::move(exceptionInputs),
+            std::move(exceptionCells));
+
+        return std::make_unique<MooreAutomata>(
+            std::move(inputSymbols),
+            std::move(mooreStatesInfo),
+            std::move(mooreTransitionTable));
     }
 
-    static void ClearImpossibleStates(MealyTransitionTable& table, MealyStates& states)
+    // Работает непосредственно с разреженной таблицей: обрабатываются только значения
+    // по умолчанию и исключения достижимых состояний
+    [[nodiscard]] std::unique_ptr<MooreAutomata> GetSparseMooreAutomata() const
     {
+        const auto& mealyTransitionTable = m_mealy->GetSparseTransitionTable();
+        const auto mealyStates = m_mealy->GetStates();
+        if (mealyStates.empty())
+        {
+            throw std::invalid_argument("Mealy automata has no states");
+        }
+        auto inputSymbols = m_mealy->GetInputSymbols();
+
         std::map<std::string, unsigned> statesIndexes;
-        for (unsigned index = 0; auto& state: states)
+        for (unsigned index = 0; auto& state: mealyStates)
         {
             statesIndexes[state] = index++;
         }
 
-        auto possibleStatesIndexes = GetPossibleStateIndexes(table, statesIndexes);
-        if (possibleStatesIndexes.empty())
+        const auto possibleStatesIndexes = GetPossibleStateIndexes(mealyTransitionTable, statesIndexes);
+
+        std::map<State, std::set<Transition>> stateToTransitions;
+        for (auto index: possibleStatesIndexes)
         {
-            return;
+            stateToTransitions[mealyStates[index]];
         }
-
-        std::vector<std::string> possibleStates;
-        for (auto it: possibleStatesIndexes)
+        for (auto index: possibleStatesIndexes)
         {
-            possibleStates.emplace_back(states.at(it));
+            mealyTransitionTable.ForEachStoredCell(index, [&](const Transition& transition) {
+                stateToTransitions[transition.nextState].emplace(transition);
+            });
         }
 
-        MealyTransitionTable updatedTable;
-        for (auto& row: table)
+        std::map<Transition, std::string> transitionToNewStateName;
+        for (unsigned newIndex = FIRST_STATE_INDEX; auto index: possibleStatesIndexes)
         {
-            std::string inputSymbol = row.first;
-            std::vector<Transition> rowStates;
+            auto& transitions = stateToTransitions[mealyStates[index]];
+            if (transitions.empty())
+            {
+                transitions.emplace(mealyStates[index], "");
+            }
 
-            for (auto it: possibleStatesIndexes)
+            for (auto& transition: transitions)
             {
-                rowStates.emplace_back(row.second.at(it));
+                transitionToNewStateName[transition] = STATE_CHAR + std::to_string(newIndex++);
             }
+        }
+
+        auto mooreStatesInfo = GetMooreStatesInfo(transitionToNewStateName);
 
-            updatedTable.emplace_back(inputSymbol, rowStates);
+        std::vector<State> defaults;
+        std::vector<size_t> offsets { 0 };
+        std::vector<unsigned> exceptionInputs;
+        std::vector<State> exceptionCells;
+        for (auto index: possibleStatesIndexes)
+        {
+            const auto inputs = mealyTransitionTable.GetExceptionInputs(index);
+            const auto transitions = mealyTransitionTable.GetExceptionCells(index);
+            const auto transitionsCount = GetTransitionsCountWithEqualState(mealyStates[index], stateToTransitions);
+            for (unsigned copy = 0; copy < transitionsCount; ++copy)
+            {
+                if (mealyTransitionTable.HasDefaults())
+                {
+                    defaults.emplace_back(transitionToNewStateName[mealyTransitionTable.GetDefault(index)]);
+                }
+                for (size_t exception = 0; exception < inputs.size(); ++exception)
+                {
+                    exceptionInputs.push_back(inputs[exception]);
+                    exceptionCells.emplace_back(transitionToNewStateName[transitions[exception]]);
+                }
+                offsets.push_back(exceptionInputs.size());
+            }
         }
 
-        states = std::move(possibleStates);
-        table = std::move(updatedTable);
+        SparseMooreTransitionTable mooreTransitionTable(
+            mealyTransitionTable.GetInputCount(),
+            std::move(defaults),
+            std::move(offsets),
+            std::move(exceptionInputs),
+            std::move(exceptionCells));
+
+        return std::make_unique<MooreAutomata>(
+            std::move(inputSymbols),
+            std::move(mooreStatesInfo),
+            std::move(mooreTransitionTable));
     }
 
-    static std::set<unsigned> GetPossibleStateIndexes(const MealyTransitionTable& table, std::map<std::string, unsigned> statesIndexes)
+    static std::set<unsigned> GetPossibleStateIndexes(const SparseMealyTransitionTable& table,
+        const std::map<std::string, unsigned>& statesIndexes)
     {
         std::vector<unsigned> possibleStateIndexesVector { 0 };
         std::set<unsigned> possibleStateIndexesSet { 0 };
         size_t possibleStateIndex = 0;
 
+        auto addState = [&](const std::string& nextState) {
+            const auto it = statesIndexes.find(nextState);
+            if (it == statesIndexes.end())
+            {
+                throw std::invalid_argument("Unknown state \"" + nextState + "\" in transition table");
+            }
+
+            if (!possibleStateIndexesSet.contains(it->second))
+            {
+                possibleStateIndexesVector.push_back(it->second);
+                possibleStateIndexesSet.emplace(it->second);
+            }
+        };
+
         while (possibleStateIndex < possibleStateIndexesVector.size())
         {
             unsigned index = possibleStateIndexesVector[possibleStateIndex++];
 
-            for (auto& row: table)
-            {
-                std::string nextState = row.second[index].nextState;
-                unsigned nextStateIndex = statesIndexes[nextState];
-
-                if (!possibleStateIndexesSet.contains(nextStateIndex))
-                {
-                    possibleStateIndexesVector.push_back(nextStateIndex);
-                    possibleStateIndexesSet.emplace(nextStateIndex);
-                }
-            }
+            table.ForEachStoredCell(index, [&](const Transition& transition) {
+                addState(transition.nextState);
+            });
         }
 
         return possibleStateIndexesSet;
     }
 
+    static unsigned GetTransitionsCountWithEqualState(const std::string& state,
+        std::map<State, std::set<Transition>>& stateToTransitions)
+    {
+        return stateToTransitions[state].size();
+    }
+
+    static MooreStatesInfo GetMooreStatesInfo(std::map<Transition, std::string>& transitionToNewStateName)
+    {
+        MooreStatesInfo mooreStateInfo;
+        for (auto& it: transitionToNewStateName)
+        {
+            mooreStateInfo.emplace_back(it.second, it.first.outputSymbol);
+        }
+
+        std::sort(mooreStateInfo.begin(), mooreStateInfo.end(), SortStringFromIndexesComp);
+
+        return mooreStateInfo;
+    }
+
+    static bool SortStringFromIndexesComp(const std::pair<std::string, std::string>& a, const std::pair<std::string, std::string>& b)
+    {
+        int numA = std::stoi(a.first.substr(1));
+        int numB = std::stoi(b.first.substr(1));
+
+        return numA < numB;
+    }
+
     std::unique_ptr<MealyAutomata> m_mealy;
+    MooreConstruction m_construction;
 };
@@ -1,6 +1,8 @@
 #pragma once
+#include <map>
 #include <memory>
 
+#include "IndexedConversion.h"
 #include "../Automata/MealyAutomata.h"
 #include "../Automata/MooreAutomata.h"
 
@@ -18,16 +20,36 @@ public:
 
     [[nodiscard]] std::unique_ptr<MealyAutomata> GetMealyAutomata() const
     {
-        MooreStatesInfo mooreStatesInfo = m_moore->GetStatesInfo();
-        MooreTransitionTable mooreTransitionTable = m_moore->GetTransitionTable();
+        if (m_moore->IsSparse())
+        {
+            MooreStatesInfo mooreStatesInfo = m_moore->GetStatesInfo();
+            auto mealyStates = GetMealyStates(mooreStatesInfo);
+            auto stateToOutputSymbolMap = GetStateToOutputSymbolMap(mooreStatesInfo);
+
+            auto mealyTransitionTable = m_moore->GetSparseTransitionTable().Map([&](std::string state) {
+                std::string outputSymbol = stateToOutputSymbolMap[state];
+                state[0] = STATE_CHAR;
+
+                return Transition(state, outputSymbol);
+            });
 
-        auto mealyStates = GetMealyStates(mooreStatesInfo);
-        auto mealyTransitionTable = GetMealyTransitionTable(mooreStatesInfo, mooreTransitionTable);
+            return std::make_unique<MealyAutomata>(
+                std::move(mealyStates), m_moore->GetInputSymbols(), std::move(mealyTransitionTable));
+        }
 
-        return std::make_unique<MealyAutomata>(mealyStates, mealyTransitionTable);
+        return GetIndexedMealyAutomata();
     }
 
 private:
+    // Автомат Мили получает ту же ширину индексов: число его состояний и выходов
+    // совпадает с числом состояний и выходов автомата Мура
+    [[nodiscard]] std::unique_ptr<MealyAutomata> GetIndexedMealyAutomata() const
+    {
+        return std::visit([&](const auto& moore) {
+            return std::make_unique<MealyAutomata>(IndexedConversion::ConvertMooreToMealy(moore, STATE_CHAR));
+        }, m_moore->GetIndexedAutomata());
+    }
+
     static MealyStates GetMealyStates(const MooreStatesInfo& statesInfo)
     {
         MealyStates mealyStates;
@@ -42,35 +64,6 @@ private:
         return mealyStates;
     }
 
-    static MealyTransitionTable GetMealyTransitionTable(const MooreStatesInfo& statesInfo,
-        const MooreTransitionTable& mooreTransitionTable)
-    {
-        MealyTransitionTable mealyTransitionTable;
-
-        auto stateToOutputSymbolMap = GetStateToOutputSymbolMap(statesInfo);
-
-        for (auto& mooreRow : mooreTransitionTable)
-        {
-            std::pair<inputSymbol, std::vector<Transition>> mealyRow;
-            mealyRow.first = mooreRow.first;
-
-            std::vector<Transition>& mealyTransitions = mealyRow.second;
-            for (std::string state : mooreRow.second)
-            {
-                std::string outputSymbol = stateToOutputSymbolMap[state];
-                state[0] = STATE_CHAR;
-
-                Transition transition(state, outputSymbol);
-
-                mealyTransitions.emplace_back(transition);
-            }
-
-            mealyTransitionTable.emplace_back(std::move(mealyRow));
-        }
-
-        return mealyTransitionTable;
-    }
-
     static std::map<State, OutputSymbol> GetStateToOutputSymbolMap(const MooreStatesInfo& statesInfo)
     {
         std::map<State, OutputSymbol> stateToOutputSymbolMap;
@@ -0,0 +1,170 @@
+#pragma once
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "../Automata/MealyAutomata.h"
+#include "../Automata/MooreAutomata.h"
+
+// Удаляет состояния, недостижимые из стартового (первого) состояния.
+// Порядок и имена оставшихся состояний сохраняются.
+namespace UnreachableStatesPruner
+{
+    // getNextStates(state, callback) вызывает callback для номера каждого следующего состояния
+    template <typename GetNextStates>
+    std::vector<unsigned> GetReachableStates(const size_t stateCount, GetNextStates&& getNextStates)
+    {
+        if (stateCount == 0)
+        {
+            return {};
+        }
+
+        std::vector<bool> isReachable(stateCount, false);
+        std::vector<unsigned> queue { 0 };
+        isReachable[0] = true;
+
+        for (size_t position = 0; position < queue.size(); ++position)
+        {
+            getNextStates(queue[position], [&](const size_t nextState) {
+                if (!isReachable[nextState])
+                {
+                    isReachable[nextState] = true;
+                    queue.push_back(static_cast<unsigned>(nextState));
+                }
+            });
+        }
+
+        std::vector<unsigned> reachableStates;
+        for (unsigned index = 0; index < stateCount; ++index)
+        {
+            if (isReachable[index])
+            {
+                reachableStates.push_back(index);
+            }
+        }
+
+        return reachableStates;
+    }
+
+    // То же для таблицы с именами: getNextStates передаёт в callback имя следующего состояния
+    template <typename GetNextStates>
+    std::vector<unsigned> GetReachableStates(const std::vector<std::string>& states, GetNextStates&& getNextStates)
+    {
+        std::unordered_map<std::string, unsigned> statesIndexes;
+        for (unsigned index = 0; auto& state: states)
+        {
+            statesIndexes.emplace(state, index++);
+        }
+
+        return GetReachableStates(states.size(), [&](const unsigned state, auto&& visit) {
+            getNextStates(state, [&](const std::string& nextState) {
+                const auto it = statesIndexes.find(nextState);
+                if (it == statesIndexes.end())
+                {
+                    throw std::invalid_argument("Unknown state \"" + nextState + "\" in transition table");
+                }
+
+                visit(it->second);
+            });
+        });
+    }
+
+    template <typename IndexedAutomata>
+    std::vector<unsigned> GetReachableStates(const IndexedAutomata& automata)
+    {
+        return GetReachableStates(automata.GetStateCount(), [&](const unsigned state, auto&& visit) {
+            for (const auto nextState: automata.GetNextStates(state))
+            {
+                visit(nextState);
+            }
+        });
+    }
+
+    template <typename Value>
+    std::vector<Value> SelectColumns(const std::vector<Value>& values, const std::vector<unsigned>& columns)
+    {
+        std::vector<Value> selected;
+        selected.reserve(columns.size());
+        for (const auto column: columns)
+        {
+            selected.push_back(values.at(column));
+        }
+
+        return selected;
+    }
+
+    inline std::unique_ptr<MealyAutomata> PruneUnreachableStates(std::unique_ptr<MealyAutomata> mealy)
+    {
+        if (!mealy->IsSparse())
+        {
+            return std::visit([&](const auto& indexed) {
+                const auto reachableStates = GetReachableStates(indexed);
+                if (reachableStates.size() == indexed.GetStateCount())
+                {
+                    return std::move(mealy);
+                }
+
+                return std::make_unique<MealyAutomata>(indexed.SelectStates(reachableStates));
+            }, mealy->GetIndexedAutomata());
+        }
+
+        const auto states = mealy->GetStates();
+        const auto& table = mealy->GetSparseTransitionTable();
+        const auto reachableStates = GetReachableStates(states, [&](const unsigned state, auto&& visit) {
+            table.ForEachStoredCell(state, [&](const Transition& transition) {
+                visit(transition.nextState);
+            });
+        });
+
+        if (reachableStates.size() == states.size())
+        {
+            return mealy;
+        }
+
+        return std::make_unique<MealyAutomata>(
+            SelectColumns(states, reachableStates),
+            mealy->GetInputSymbols(),
+            table.SelectStates(reachableStates));
+    }
+
+    inline std::unique_ptr<MooreAutomata> PruneUnreachableStates(std::unique_ptr<MooreAutomata> moore)
+    {
+        if (!moore->IsSparse())
+        {
+            return std::visit([&](const auto& indexed) {
+                const auto reachableStates = GetReachableStates(indexed);
+                if (reachableStates.size() == indexed.GetStateCount())
+                {
+                    return std::move(moore);
+                }
+
+                return std::make_unique<MooreAutomata>(indexed.SelectStates(reachableStates));
+            }, moore->GetIndexedAutomata());
+        }
+
+        const auto statesInfo = moore->GetStatesInfo();
+        std::vector<std::string> states;
+        for (auto& info: statesInfo)
+        {
+            states.push_back(info.first);
+        }
+
+        const auto& table = moore->GetSparseTransitionTable();
+        const auto reachableStates = GetReachableStates(states, [&](const unsigned state, auto&& visit) {
+            table.ForEachStoredCell(state, visit);
+        });
+
+        if (reachableStates.size() == states.size())
+        {
+            return moore;
+        }
+
+        return std::make_unique<MooreAutomata>(
+            moore->GetInputSymbols(),
+            SelectColumns(statesInfo, reachableStates),
+            table.SelectStates(reachableStates));
+    }
+}
@@ -0,0 +1,694 @@
+#pragma once
+
+#ifndef COMPRESSED_STREAM_H
+#define COMPRESSED_STREAM_H
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef MEALY_MOORE_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef MEALY_MOORE_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+enum class CompressionFormat
+{
+    // Для записи формат определяется по расширению файла (.gz, .zst)
+    Auto,
+    None,
+    Gzip,
+    Zstd
+};
+
+struct OutputCompression
+{
+    CompressionFormat format = CompressionFormat::Auto;
+    // Если не задан, используется уровень сжатия библиотеки по умолчанию
+    std::optional<int> level;
+};
+
+namespace CompressedStream
+{
+    constexpr size_t CHUNK_SIZE = 1 << 18;
+    constexpr size_t QUEUE_CAPACITY = 4;
+
+    using Chunk = std::vector<char>;
+
+    // Ограниченная очередь блоков между потоком чтения/записи файла и парсером/экспортёром
+    class ChunkQueue
+    {
+    public:
+        // Возвращает false, если получатель больше не принимает данные
+        bool Push(Chunk&& chunk)
+        {
+            std::unique_lock lock(m_mutex);
+            m_notFull.wait(lock, [&] { return m_chunks.size() < QUEUE_CAPACITY || m_isCancelled; });
+            if (m_isCancelled)
+            {
+                return false;
+            }
+
+            m_chunks.emplace_back(std::move(chunk));
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        // Возвращает std::nullopt, когда очередь закрыта и все блоки прочитаны
+        std::optional<Chunk> Pop()
+        {
+            std::unique_lock lock(m_mutex);
+            m_notEmpty.wait(lock, [&] { return !m_chunks.empty() || m_isClosed || m_isCancelled; });
+            if (m_chunks.empty() || m_isCancelled)
+            {
+                return std::nullopt;
+            }
+
+            Chunk chunk = std::move(m_chunks.front());
+            m_chunks.pop_front();
+            m_notFull.notify_one();
+            return chunk;
+        }
+
+        void Close()
+        {
+            std::lock_guard lock(m_mutex);
+            m_isClosed = true;
+            m_notEmpty.notify_all();
+        }
+
+        void Cancel()
+        {
+            std::lock_guard lock(m_mutex);
+            m_isCancelled = true;
+            m_notEmpty.notify_all();
+            m_notFull.notify_all();
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+        std::deque<Chunk> m_chunks;
+        bool m_isClosed = false;
+        bool m_isCancelled = false;
+    };
+
+    using Producer = std::function<void(std::ifstream&, ChunkQueue&)>;
+    using Consumer = std::function<void(ChunkQueue&, std::ofstream&)>;
+
+    // Буфер чтения, который получает распакованные данные от отдельного потока
+    class AsyncInputBuffer final : public std::streambuf
+    {
+    public:
+        AsyncInputBuffer(std::ifstream&& file, Producer producer)
+            : m_file(std::move(file))
+        {
+            m_thread = std::thread([this, producer = std::move(producer)] {
+                try
+                {
+                    producer(m_file, m_queue);
+                }
+                catch (...)
+                {
+                    m_error = std::current_exception();
+                }
+                m_queue.Close();
+            });
+        }
+
+        ~AsyncInputBuffer() override
+        {
+            m_queue.Cancel();
+            m_thread.join();
+        }
+
+    protected:
+        int_type underflow() override
+        {
+            if (gptr() < egptr())
+            {
+                return traits_type::to_int_type(*gptr());
+            }
+
+            auto chunk = m_queue.Pop();
+            if (!chunk)
+            {
+                if (m_error)
+                {
+                    std::rethrow_exception(m_error);
+                }
+                return traits_type::eof();
+            }
+
+            m_current = std::move(*chunk);
+            setg(m_current.data(), m_current.data(), m_current.data() + m_current.size());
+            return traits_type::to_int_type(*gptr());
+        }
+
+    private:
+        std::ifstream m_file;
+        ChunkQueue m_queue;
+        Chunk m_current;
+        std::exception_ptr m_error;
+        std::thread m_thread;
+    };
+
+    // Буфер записи, который передаёт данные на сжатие отдельному потоку
+    class AsyncOutputBuffer final : public std::streambuf
+    {
+    public:
+        AsyncOutputBuffer(std::ofstream&& file, Consumer consumer)
+            : m_file(std::move(file))
+        {
+            ResetBuffer();
+            m_thread = std::thread([this, consumer = std::move(consumer)] {
+                try
+                {
+                    consumer(m_queue, m_file);
+                    m_file.close();
+                    if (m_file.fail())
+                    {
+                        throw std::runtime_error("Could not write compressed file");
+                    }
+                }
+                catch (...)
+                {
+                    m_error = std::current_exception();
+                    m_queue.Cancel();
+                }
+            });
+        }
+
+        ~AsyncOutputBuffer() override
+        {
+            try
+            {
+                Finish();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        // Дописывает оставшиеся данные и дожидается окончания сжатия
+        void Finish()
+        {
+            if (m_thread.joinable())
+            {
+                FlushBuffer();
+                m_queue.Close();
+                m_thread.join();
+            }
+
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+        }
+
+    protected:
+        int_type overflow(const int_type ch) override
+        {
+            if (!FlushBuffer())
+            {
+                return traits_type::eof();
+            }
+
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+
+            return traits_type::not_eof(ch);
+        }
+
+        int sync() override
+        {
+            return FlushBuffer() ? 0 : -1;
+        }
+
+    private:
+        bool FlushBuffer()
+        {
+            if (pptr() == pbase())
+            {
+                return true;
+            }
+
+            m_current.resize(pptr() - pbase());
+            const bool isPushed = m_queue.Push(std::move(m_current));
+            ResetBuffer();
+
+            return isPushed;
+        }
+
+        void ResetBuffer()
+        {
+            m_current.assign(CHUNK_SIZE, '\0');
+            setp(m_current.data(), m_current.data() + m_current.size());
+        }
+
+        std::ofstream m_file;
+        ChunkQueue m_queue;
+        Chunk m_current;
+        std::exception_ptr m_error;
+        std::thread m_thread;
+    };
+
+    inline void WriteChunk(std::ofstream& file, const char* data, const size_t size)
+    {
+        if (!file.write(data, static_cast<std::streamsize>(size)))
+        {
+            throw std::runtime_error("Could not write compressed file");
+        }
+    }
+
+#ifdef MEALY_MOORE_HAS_ZLIB
+    inline void InflateGzip(std::ifstream& file, ChunkQueue& queue)
+    {
+        z_stream stream {};
+        if (inflateInit2(&stream, MAX_WBITS + 32) != Z_OK)
+        {
+            throw std::runtime_error("Could not initialize gzip decompression");
+        }
+        std::unique_ptr<z_stream, decltype(&inflateEnd)> guard(&stream, &inflateEnd);
+
+        Chunk input(CHUNK_SIZE);
+        while (true)
+        {
+            if (stream.avail_in == 0 && file)
+            {
+                file.read(input.data(), static_cast<std::streamsize>(input.size()));
+                stream.next_in = reinterpret_cast<Bytef*>(input.data());
+                stream.avail_in = static_cast<uInt>(file.gcount());
+            }
+
+            Chunk output(CHUNK_SIZE);
+            stream.next_out = reinterpret_cast<Bytef*>(output.data());
+            stream.avail_out = static_cast<uInt>(output.size());
+
+            const int result = inflate(&stream, Z_NO_FLUSH);
+            if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+            {
+                throw std::runtime_error("Corrupted gzip stream");
+            }
+
+            output.resize(output.size() - stream.avail_out);
+            if (!output.empty() && !queue.Push(std::move(output)))
+            {
+                return;
+            }
+
+            if (result == Z_STREAM_END)
+            {
+                if (stream.avail_in == 0 && (!file || file.peek() == std::char_traits<char>::eof()))
+                {
+                    return;
+                }
+                // Следующий gzip-член в том же файле
+                inflateReset(&stream);
+            }
+            else if (stream.avail_in == 0 && !file && stream.avail_out != 0)
+            {
+                throw std::runtime_error("Unexpected end of gzip stream");
+            }
+        }
+    }
+
+    inline void DeflateGzip(ChunkQueue& queue, std::ofstream& file, const std::optional<int> level)
+    {
+        z_stream stream {};
+        if (deflateInit2(&stream, level.value_or(Z_DEFAULT_COMPRESSION), Z_DEFLATED, MAX_WBITS + 16, 8,
+            Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            throw std::invalid_argument("Invalid gzip compression level");
+        }
+        std::unique_ptr<z_stream, decltype(&deflateEnd)> guard(&stream, &deflateEnd);
+
+        Chunk output(CHUNK_SIZE);
+        auto deflateChunk = [&](const int flush) {
+            int result;
+            do
+            {
+                stream.next_out = reinterpret_cast<Bytef*>(output.data());
+                stream.avail_out = static_cast<uInt>(output.size());
+                result = deflate(&stream, flush);
+                if (result == Z_STREAM_ERROR)
+                {
+                    throw std::runtime_error("gzip compression failed");
+                }
+                WriteChunk(file, output.data(), output.size() - stream.avail_out);
+            }
+            while (stream.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+        };
+
+        while (auto chunk = queue.Pop())
+        {
+            stream.next_in = reinterpret_cast<Bytef*>(chunk->data());
+            stream.avail_in = static_cast<uInt>(chunk->size());
+            deflateChunk(Z_NO_FLUSH);
+        }
+
+        stream.avail_in = 0;
+        deflateChunk(Z_FINISH);
+    }
+#endif
+
+#ifdef MEALY_MOORE_HAS_ZSTD
+    inline void DecompressZstd(std::ifstream& file, ChunkQueue& queue)
+    {
+        std::unique_ptr<ZSTD_DStream, decltype(&ZSTD_freeDStream)> stream(ZSTD_createDStream(), &ZSTD_freeDStream);
+        if (!stream)
+        {
+            throw std::runtime_error("Could not initialize zstd decompression");
+        }
+
+        Chunk input(ZSTD_DStreamInSize());
+        size_t lastResult = 0;
+        while (file.read(input.data(), static_cast<std::streamsize>(input.size())) || file.gcount() > 0)
+        {
+            ZSTD_inBuffer in { input.data(), static_cast<size_t>(file.gcount()), 0 };
+            // Заполненный выходной буфер означает, что у декодера могут остаться данные
+            bool isOutputFull = false;
+            while (in.pos < in.size || isOutputFull)
+            {
+                Chunk output(ZSTD_DStreamOutSize());
+                ZSTD_outBuffer out { output.data(), output.size(), 0 };
+                lastResult = ZSTD_decompressStream(stream.get(), &out, &in);
+                if (ZSTD_isError(lastResult))
+                {
+                    throw std::runtime_error(std::string("Corrupted zstd stream: ") + ZSTD_getErrorName(lastResult));
+                }
+                isOutputFull = out.pos == out.size;
+
+                output.resize(out.pos);
+                if (!output.empty() && !queue.Push(std::move(output)))
+                {
+                    return;
+                }
+            }
+        }
+
+        if (lastResult != 0)
+        {
+            throw std::runtime_error("Unexpected end of zstd stream");
+        }
+    }
+
+    inline void CompressZstd(ChunkQueue& queue, std::ofstream& file, const std::optional<int> level)
+    {
+        std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+        if (!context)
+        {
+            throw std::runtime_error("Could not initialize zstd compression");
+        }
+        if (ZSTD_isError(ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel,
+            level.value_or(ZSTD_CLEVEL_DEFAULT))))
+        {
+            throw std::invalid_argument("Invalid zstd compression level");
+        }
+
+        Chunk output(ZSTD_CStreamOutSize());
+        auto compressChunk = [&](const char* data, const size_t size, const ZSTD_EndDirective directive) {
+            ZSTD_inBuffer in { data, size, 0 };
+            size_t remaining;
+            do
+            {
+                ZSTD_outBuffer out { output.data(), output.size(), 0 };
+                remaining = ZSTD_compressStream2(context.get(), &out, &in, directive);
+                if (ZSTD_isError(remaining))
+                {
+                    throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(remaining));
+                }
+                WriteChunk(file, output.data(), out.pos);
+            }
+            while (directive == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+        };
+
+        while (auto chunk = queue.Pop())
+        {
+            compressChunk(chunk->data(), chunk->size(), ZSTD_e_continue);
+        }
+
+        compressChunk(nullptr, 0, ZSTD_e_end);
+    }
+#endif
+
+    inline CompressionFormat DetectFormat(std::ifstream& file)
+    {
+        std::array<unsigned char, 4> magic {};
+        file.read(reinterpret_cast<char*>(magic.data()), magic.size());
+        const auto size = file.gcount();
+        file.clear();
+        file.seekg(0);
+
+        if (size >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+        {
+            return CompressionFormat::Gzip;
+        }
+        if (size == 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+        {
+            return CompressionFormat::Zstd;
+        }
+
+        return CompressionFormat::None;
+    }
+
+    inline CompressionFormat GetFormatFromExtension(const std::string& filename)
+    {
+        auto endsWith = [&](const std::string& extension) {
+            return filename.size() >= extension.size()
+                && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+        };
+
+        if (endsWith(".gz"))
+        {
+            return CompressionFormat::Gzip;
+        }
+        if (endsWith(".zst"))
+        {
+            return CompressionFormat::Zstd;
+        }
+
+        return CompressionFormat::None;
+    }
+
+    [[noreturn]] inline void ThrowUnsupported(const std::string& format)
+    {
+        throw std::runtime_error("Program was built without " + format + " support");
+    }
+
+    // Проверяет формат и уровень сжатия до создания файла, чтобы ошибка не оставляла пустой файл
+    inline void ValidateOutputCompression(const CompressionFormat format, const std::optional<int> level)
+    {
+        switch (format)
+        {
+            case CompressionFormat::Gzip:
+#ifdef MEALY_MOORE_HAS_ZLIB
+            {
+                if (!level.has_value())
+                {
+                    return;
+                }
+                z_stream stream {};
+                if (deflateInit2(&stream, *level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                {
+                    throw std::invalid_argument("Invalid gzip compression level " + std::to_string(*level));
+                }
+                deflateEnd(&stream);
+                return;
+            }
+#else
+                ThrowUnsupported("gzip");
+#endif
+            case CompressionFormat::Zstd:
+#ifdef MEALY_MOORE_HAS_ZSTD
+            {
+                const auto bounds = ZSTD_cParam_getBounds(ZSTD_c_compressionLevel);
+                if (level.has_value() && (ZSTD_isError(bounds.error) || *level < bounds.lowerBound || *level > bounds.upperBound))
+                {
+                    throw std::invalid_argument("Invalid zstd compression level " + std::to_string(*level));
+                }
+                return;
+            }
+#else
+                ThrowUnsupported("zstd");
+#endif
+            default:
+                if (level.has_value())
+                {
+                    throw std::invalid_argument("Compression level requires .gz or .zst output");
+                }
+        }
+    }
+
+    // Поток чтения файла; сжатые gzip/zstd файлы распаковываются на лету в отдельном потоке
+    class InputFile final : public std::istream
+    {
+    public:
+        explicit InputFile(const std::string& filename)
+            : std::istream(nullptr)
+        {
+            std::ifstream file(filename, std::ios::binary);
+            if (!file.is_open())
+            {
+                return;
+            }
+            m_isOpen = true;
+
+            switch (DetectFormat(file))
+            {
+                case CompressionFormat::Gzip:
+#ifdef MEALY_MOORE_HAS_ZLIB
+                    m_buffer = std::make_unique<AsyncInputBuffer>(std::move(file), InflateGzip);
+                    break;
+#else
+                    ThrowUnsupported("gzip");
+#endif
+                case CompressionFormat::Zstd:
+#ifdef MEALY_MOORE_HAS_ZSTD
+                    m_buffer = std::make_unique<AsyncInputBuffer>(std::move(file), DecompressZstd);
+                    break;
+#else
+                    ThrowUnsupported("zstd");
+#endif
+                default:
+                {
+                    file.close();
+                    auto buffer = std::make_unique<std::filebuf>();
+                    buffer->open(filename, std::ios::in);
+                    m_buffer = std::move(buffer);
+                    break;
+                }
+            }
+
+            rdbuf(m_buffer.get());
+            // Ошибки распаковки пробрасываются из underflow в парсер
+            exceptions(std::ios::badbit);
+        }
+
+        [[nodiscard]] bool IsOpen() const
+        {
+            return m_isOpen;
+        }
+
+    private:
+        std::unique_ptr<std::streambuf> m_buffer;
+        bool m_isOpen = false;
+    };
+
+    // Поток записи файла; при сжатии данные передаются отдельному потоку
+    class OutputFile final : public std::ostream
+    {
+    public:
+        OutputFile(const std::string& filename, const OutputCompression& compression)
+            : std::ostream(nullptr)
+        {
+            const auto format = compression.format == CompressionFormat::Auto
+                ? GetFormatFromExtension(filename)
+                : compression.format;
+            ValidateOutputCompression(format, compression.level);
+
+            std::ofstream file(filename, std::ios::binary);
+            if (!file.is_open())
+            {
+                return;
+            }
+            m_isOpen = true;
+
+            switch (format)
+            {
+                case CompressionFormat::Gzip:
+#ifdef MEALY_MOORE_HAS_ZLIB
+                {
+                    auto buffer = std::make_unique<AsyncOutputBuffer>(std::move(file),
+                        [level = compression.level](ChunkQueue& queue, std::ofstream& output) {
+                            DeflateGzip(queue, output, level);
+                        });
+                    m_asyncBuffer = buffer.get();
+                    m_buffer = std::move(buffer);
+                    break;
+                }
+#else
+                    ThrowUnsupported("gzip");
+#endif
+                case CompressionFormat::Zstd:
+#ifdef MEALY_MOORE_HAS_ZSTD
+                {
+                    auto buffer = std::make_unique<AsyncOutputBuffer>(std::move(file),
+                        [level = compression.level](ChunkQueue& queue, std::ofstream& output) {
+                            CompressZstd(queue, output, level);
+                        });
+                    m_asyncBuffer = buffer.get();
+                    m_buffer = std::move(buffer);
+                    break;
+                }
+#else
+                    ThrowUnsupported("zstd");
+#endif
+                default:
+                {
+                    // Как и сжатые файлы, пишется в двоичном режиме: строки оканчиваются '\n'
+                    // на любой платформе, и смещения строк совпадают с байтами файла
+                    file.close();
+                    auto buffer = std::make_unique<std::filebuf>();
+                    buffer->open(filename, std::ios::out | std::ios::trunc | std::ios::binary);
+                    m_buffer = std::move(buffer);
+                    break;
+                }
+            }
+
+            rdbuf(m_buffer.get());
+        }
+
+        [[nodiscard]] bool IsOpen() const
+        {
+            return m_isOpen;
+        }
+
+        // Завершает запись; ошибки сжатия и записи пробрасываются отсюда
+        void Close()
+        {
+            flush();
+            if (m_asyncBuffer != nullptr)
+            {
+                m_asyncBuffer->Finish();
+            }
+            else if (auto* buffer = dynamic_cast<std::filebuf*>(m_buffer.get()); buffer != nullptr && !buffer->close())
+            {
+                setstate(std::ios::badbit);
+            }
+
+            if (bad())
+            {
+                throw std::runtime_error("Could not write the file");
+            }
+        }
+
+    private:
+        std::unique_ptr<std::streambuf> m_buffer;
+        AsyncOutputBuffer* m_asyncBuffer = nullptr;
+        bool m_isOpen = false;
+    };
+}
+
+#endif
@@ -1,45 +1,126 @@
+#include <chrono>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <variant>
 
 #include "ArgumentsParser.h"
 #include "AutomataController.h"
-#include "Converter/MealyToMooreConverter.h"
+#include "Converter/IncrementalMealyToMooreConverter.h"
 #include "Converter/MealyToMooreConverter.h"
 #include "Converter/MooreToMealyConverter.h"
+#include "Converter/UnreachableStatesPruner.h"
+
+using AnyAutomata = std::variant<std::unique_ptr<MealyAutomata>, std::unique_ptr<MooreAutomata>>;
 
-void MealyToMooreConversion(Args& args)
+void RunStage(const std::string& name, const std::function<void()>& stage)
 {
-    auto mealy = MealyController::GetMealyAutomataFromCsvFile(args.inputFilename);
+    const auto start = std::chrono::steady_clock::now();
+    stage();
+    const auto end = std::chrono::steady_clock::now();
 
-    MealyToMooreConverter converter((std::move(mealy)));
-    auto moore = converter.GetMooreAutomata();
+    std::cout << name << ": " << std::fixed << std::setprecision(2)
+        << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+}
 
-    moore->ExportToCsv(args.outputFilename);
+AnyAutomata LoadAutomata(const Args& args)
+{
+    if (args.inputType == AutomataType::Mealy)
+    {
+        return MealyController::GetMealyAutomataFromCsvFile(args.inputFilename);
+    }
+
+    return MooreController::GetMooreAutomataFromCsvFile(args.inputFilename);
 }
 
-void MooreToMealyConversion(Args& args)
+AnyAutomata ApplyOperation(const Operation operation, AnyAutomata automata, const Args& args)
 {
-    auto moore = MooreController::GetMooreAutomataFromCsvFile(args.inputFilename);
+    switch (operation)
+    {
+        case Operation::MealyToMoore:
+        {
+            MealyToMooreConverter converter(std::get<std::unique_ptr<MealyAutomata>>(std::move(automata)),
+                args.reachableOnly ? MooreConstruction::Reachable : MooreConstruction::Full);
+            return converter.GetMooreAutomata();
+        }
+        case Operation::MooreToMealy:
+        {
+            MooreToMealyConverter converter(std::get<std::unique_ptr<MooreAutomata>>(std::move(automata)));
+            return converter.GetMealyAutomata();
+        }
+        case Operation::Prune:
+            return std::visit([](auto&& loaded) -> AnyAutomata {
+                return UnreachableStatesPruner::PruneUnreachableStates(std::move(loaded));
+            }, std::move(automata));
+        default:
+            throw std::invalid_argument("Invalid operation");
+    }
+}
 
-    MooreToMealyConverter converter(std::move(moore));
-    auto mealy = converter.GetMealyAutomata();
+std::string GetOperationName(const Operation operation)
+{
+    switch (operation)
+    {
+        case Operation::MealyToMoore:
+            return MEALY_TO_MOORE;
+        case Operation::MooreToMealy:
+            return MOORE_TO_MEALY;
+        default:
+            return PRUNE;
+    }
+}
 
-    mealy->ExportToCsv(args.outputFilename);
+void RunIncrementalConversion(const Args& args)
+{
+    IncrementalResult result;
+    RunStage("incremental " + MEALY_TO_MOORE, [&] {
+        IncrementalMealyToMooreConverter converter(args.inputFilename, args.outputFilename,
+            { CompressionFormat::Auto, args.compressionLevel });
+        result = converter.Convert();
+    });
+
+    if (result.isFullConversion)
+    {
+        std::cout << "incremental: full conversion (" << result.fullConversionReason << ")\n";
+        return;
+    }
+
+    std::cout << "incremental: " << result.changedRows << " changed rows, " << result.rewrittenRows
+        << " Moore rows rewritten " << (result.isRewrittenInPlace ? "in place" : "with file copy") << "\n";
+}
+
+void RunOperations(const Args& args)
+{
+    if (args.incremental)
+    {
+        RunIncrementalConversion(args);
+        return;
+    }
+
+    AnyAutomata automata;
+    RunStage("load", [&] {
+        automata = LoadAutomata(args);
+    });
+
+    for (const auto operation: args.operations)
+    {
+        RunStage(GetOperationName(operation), [&] {
+            automata = ApplyOperation(operation, std::move(automata), args);
+        });
+    }
+
+    RunStage("export", [&] {
+        std::visit([&](const auto& result) {
+            result->ExportToCsv(args.outputFilename, { CompressionFormat::Auto, args.compressionLevel });
+        }, automata);
+    });
 }
 
 int main(const int argc, char** argv)
 {
     try
     {
-        switch (auto args = ParseArgs(argc, argv); args.operation)
-        {
-            case Operation::MealyToMoore:
-                MealyToMooreConversion(args);
-                break;
-            case Operation::MooreToMealy:
-                MooreToMealyConversion(args);
-                break;
-            default: break;
-        }
+        RunOperations(ParseArgs(argc, argv));
 
         std::cout << "Converted!\n";
     }